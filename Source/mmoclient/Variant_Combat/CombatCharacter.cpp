@@ -17,9 +17,13 @@
 #include "CombatPlayerController.h"
 #include "Network/CombatNetworkSubsystem.h"
 #include "Network/CombatRemotePlayer.h"
+#include "Network/CombatPredictedMovementComponent.h"
+#include "Network/CombatRemotePlayerManager.h"
+#include "Network/CombatNetworkSettings.h"
 #include "Kismet/GameplayStatics.h"
 
-ACombatCharacter::ACombatCharacter()
+ACombatCharacter::ACombatCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCombatPredictedMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -144,6 +148,9 @@ void ACombatCharacter::DoComboAttackStart()
 
 	// perform a combo attack
 	ComboAttack();
+
+	// don't wait for the network tick to show the swing
+	SendStateNow();
 }
 
 void ACombatCharacter::DoComboAttackEnd()
@@ -176,6 +183,9 @@ void ACombatCharacter::DoChargedAttackEnd()
 	if (bHasLoopedChargedAttack)
 	{
 		CheckChargedAttack();
+
+		// don't wait for the network tick to show the release
+		SendStateNow();
 	}
 }
 
@@ -202,6 +212,9 @@ void ACombatCharacter::ComboAttack()
 	// notify enemies they are about to be attacked
 	NotifyEnemiesOfIncomingAttack();
 
+	// let remote clients play the attack
+	SendCombatEvent(ECombatEventType::AttackStart);
+
 	// play the attack montage
 	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 	{
@@ -228,6 +241,9 @@ void ACombatCharacter::ChargedAttack()
 	// notify enemies they are about to be attacked
 	NotifyEnemiesOfIncomingAttack();
 
+	// let remote clients play the charge
+	SendCombatEvent(ECombatEventType::ChargeStart);
+
 	// play the charged attack montage
 	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 	{
@@ -264,6 +280,40 @@ void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupt
 	}
 }
 
+void ACombatCharacter::SendCombatEvent(ECombatEventType Type, int32 ComboStage)
+{
+	// only the local player's actions are ours to announce
+	if (!IsPlayerControlled() || !IsLocallyControlled())
+	{
+		return;
+	}
+
+	if (UGameInstance* GameInstance = GetGameInstance())
+	{
+		if (UCombatNetworkSubsystem* NetworkSubsystem = GameInstance->GetSubsystem<UCombatNetworkSubsystem>())
+		{
+			NetworkSubsystem->SendCombatEvent(Type, ComboStage);
+		}
+	}
+}
+
+void ACombatCharacter::SendStateNow()
+{
+	// only the local player's state is ours to send
+	if (!IsPlayerControlled() || !IsLocallyControlled())
+	{
+		return;
+	}
+
+	if (UGameInstance* GameInstance = GetGameInstance())
+	{
+		if (UCombatNetworkSubsystem* NetworkSubsystem = GameInstance->GetSubsystem<UCombatNetworkSubsystem>())
+		{
+			NetworkSubsystem->RequestStateSend();
+		}
+	}
+}
+
 void ACombatCharacter::DoAttackTrace(FName DamageSourceBone)
 {
 	// sweep for objects in front of the character to be hit by the attack
@@ -314,7 +364,22 @@ void ACombatCharacter::DoAttackTrace(FName DamageSourceBone)
 				// Send attack to server - server validates and applies damage
 				if (NetworkSubsystem && NetworkSubsystem->IsConnected())
 				{
-					NetworkSubsystem->SendAttack(RemotePlayer->GetPlayerId());
+					// The server rewinds the target to the time it was drawn at; check the hit the same way first
+					double RenderTime = 0.0;
+					FVector HitLocation = CurrentHit.ImpactPoint;
+					if (const UCombatRemotePlayerManager* ProxyManager = GetWorld()->GetSubsystem<UCombatRemotePlayerManager>())
+					{
+						RenderTime = ProxyManager->GetRenderTime(RemotePlayer);
+						if (RenderTime > 0.0 && GetDefault<UCombatNetworkSettings>()->bValidateMeleeHits
+							&& !ProxyManager->ValidateMeleeHit(RemotePlayer, RenderTime, TraceStart, TraceEnd, MeleeTraceRadius, HitLocation))
+						{
+							// The server would reject it; don't spend an attack message on it
+							UE_LOG(LogCombatNetwork, Verbose, TEXT("Skipping attack on %s: missed the rewound position"), *RemotePlayer->GetPlayerId());
+							continue;
+						}
+					}
+
+					NetworkSubsystem->SendAttack(RemotePlayer->GetPlayerId(), RenderTime, HitLocation);
 					// Play attack effect locally (server will confirm damage)
 					DealtDamage(MeleeDamage, CurrentHit.ImpactPoint);
 				}
@@ -359,6 +424,9 @@ void ACombatCharacter::CheckCombo()
 				// notify enemies they are about to be attacked
 				NotifyEnemiesOfIncomingAttack();
 
+				// let remote clients follow the combo
+				SendCombatEvent(ECombatEventType::ComboAdvance, ComboCount);
+
 				// jump to the next combo section
 				if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 				{
@@ -374,6 +442,12 @@ void ACombatCharacter::CheckChargedAttack()
 	// raise the looped charged attack flag
 	bHasLoopedChargedAttack = true;
 
+	// let remote clients play the release
+	if (!bIsChargingAttack)
+	{
+		SendCombatEvent(ECombatEventType::ChargeRelease);
+	}
+
 	// jump to either the loop or the attack section depending on whether we're still holding the charge button
 	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 	{
@@ -431,6 +505,9 @@ void ACombatCharacter::ApplyDamage(float Damage, AActor* DamageCauser, const FVe
 		// apply the knockback impulse
 		GetCharacterMovement()->AddImpulse(DamageImpulse, true);
 
+		// let remote clients play the hit
+		SendCombatEvent(ECombatEventType::Hit);
+
 		// is the character ragdolling?
 		if (GetMesh()->IsSimulatingPhysics())
 		{
@@ -449,6 +526,9 @@ void ACombatCharacter::HandleDeath()
 	// disable movement while we're dead
 	GetCharacterMovement()->DisableMovement();
 
+	// let remote clients play the death
+	SendCombatEvent(ECombatEventType::Death);
+
 	// enable full ragdoll physics
 	GetMesh()->SetSimulatePhysics(true);
 
@@ -591,6 +671,21 @@ void ACombatCharacter::Landed(const FHitResult& Hit)
 	}
 }
 
+void ACombatCharacter::OnJumped_Implementation()
+{
+	Super::OnJumped_Implementation();
+
+	// replayed jumps already went out when they first happened
+	const UCombatPredictedMovementComponent* PredictedMovement = Cast<UCombatPredictedMovementComponent>(GetCharacterMovement());
+	if (PredictedMovement && PredictedMovement->IsReplaying())
+	{
+		return;
+	}
+
+	// the movement component has just launched us, so the state carries the jump velocity
+	SendStateNow();
+}
+
 void ACombatCharacter::BeginPlay()
 {
 	Super::BeginPlay();
@@ -192,8 +192,8 @@ protected:
 
 public:
 	
-	/** Constructor */
-	ACombatCharacter();
+	/** Constructor. Uses the predicted movement component */
+	ACombatCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 
@@ -259,6 +259,12 @@ protected:
 	/** Called from a delegate when the attack montage ends */
 	void AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+	/** Sends a combat event to the server if this is the local player, so remote clients can play it */
+	void SendCombatEvent(ECombatEventType Type, int32 ComboStage = 0);
+
+	/** Has the local player's state sent at the end of this frame instead of on the next network tick, so remote clients see an action sooner */
+	void SendStateNow();
+
 	
 public:
 
@@ -313,6 +319,9 @@ public:
 	/** Overrides landing to reset damage ragdoll physics */
 	virtual void Landed(const FHitResult& Hit) override;
 
+	/** Overrides jumping to send the take-off right away */
+	virtual void OnJumped_Implementation() override;
+
 public:
 
 	/** Blueprint handler to play damage dealt effects */
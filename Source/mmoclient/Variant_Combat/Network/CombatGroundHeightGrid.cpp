@@ -0,0 +1,318 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatGroundHeightGrid.h"
+#include "CombatNetworkSettings.h"
+#include "CombatNetworkSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/LevelBounds.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	/** First bytes of a baked grid file, "CBGH" */
+	constexpr uint32 GroundGridMagic = 0x48474243;
+
+	/** Bumped whenever the baked file layout changes; older files are ignored */
+	constexpr int32 GroundGridVersion = 1;
+
+	/** How far above and below a point the ground is traced for */
+	constexpr double GroundTraceExtent = 50000.0;
+
+	/** Surfaces with a flatter normal than this can't be stood on, as for a character's default walkable slope */
+	constexpr float MinWalkableNormalZ = 0.71f;
+
+	/** Traces down from Start to End for level geometry. Other players never count as ground */
+	bool TraceDown(const UWorld* World, const FVector& Start, const FVector& End, FHitResult& OutHit)
+	{
+		const FCollisionQueryParams Params(SCENE_QUERY_STAT(CombatGroundHeight), false);
+		const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+		return World->LineTraceSingleByObjectType(OutHit, Start, End, ObjectParams, Params);
+	}
+}
+
+bool UCombatGroundHeightGrid::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Editor worlds too, so the grid can be baked from a level loaded in the editor
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE || WorldType == EWorldType::Editor;
+}
+
+void UCombatGroundHeightGrid::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(GetDefault<UCombatNetworkSettings>()->GroundGridCellSize, 10.0f);
+}
+
+void UCombatGroundHeightGrid::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (GetDefault<UCombatNetworkSettings>()->bUseGroundHeightGrid)
+	{
+		Load();
+	}
+}
+
+bool UCombatGroundHeightGrid::FindGroundHeight(const FVector& Position, double& OutGroundZ)
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return false;
+	}
+
+	const UCombatNetworkSettings* Settings = GetDefault<UCombatNetworkSettings>();
+	if (!Settings->bUseGroundHeightGrid)
+	{
+		return TraceGroundHeight(World, Position, OutGroundZ);
+	}
+
+	const double GridX = Position.X / CellSize;
+	const double GridY = Position.Y / CellSize;
+	const int32 X = FMath::FloorToInt32(GridX);
+	const int32 Y = FMath::FloorToInt32(GridY);
+
+	// The four points around Position: X/Y, X+1/Y, X/Y+1, X+1/Y+1
+	float Heights[4];
+	for (int32 Corner = 0; Corner < 4; ++Corner)
+	{
+		if (FindOrTracePoint(X + (Corner & 1), Y + (Corner >> 1), Heights[Corner]) != EPointState::Ground)
+		{
+			return TraceGroundHeight(World, Position, OutGroundZ);
+		}
+	}
+
+	const float MinHeight = FMath::Min(FMath::Min(Heights[0], Heights[1]), FMath::Min(Heights[2], Heights[3]));
+	const float MaxHeight = FMath::Max(FMath::Max(Heights[0], Heights[1]), FMath::Max(Heights[2], Heights[3]));
+	if (MaxHeight - MinHeight > Settings->GroundGridMaxHeightSpread)
+	{
+		return TraceGroundHeight(World, Position, OutGroundZ);
+	}
+
+	OutGroundZ = FMath::BiLerp(Heights[0], Heights[1], Heights[2], Heights[3], static_cast<float>(GridX - X), static_cast<float>(GridY - Y));
+	return true;
+}
+
+int32 UCombatGroundHeightGrid::Build(const FBox2D& Bounds)
+{
+	const int32 MinX = FMath::FloorToInt32(Bounds.Min.X / CellSize);
+	const int32 MinY = FMath::FloorToInt32(Bounds.Min.Y / CellSize);
+	const int32 MaxX = FMath::CeilToInt32(Bounds.Max.X / CellSize);
+	const int32 MaxY = FMath::CeilToInt32(Bounds.Max.Y / CellSize);
+
+	int32 NumPoints = 0;
+	for (int32 Y = MinY; Y <= MaxY; ++Y)
+	{
+		for (int32 X = MinX; X <= MaxX; ++X)
+		{
+			int32 Index;
+			FChunk& Chunk = FindOrAddChunk(X, Y, Index);
+			Chunk.States[Index] = TracePoint(X, Y, Chunk.Heights[Index]);
+			++NumPoints;
+		}
+	}
+	return NumPoints;
+}
+
+UCombatGroundHeightGrid::EPointState UCombatGroundHeightGrid::FindOrTracePoint(int32 X, int32 Y, float& OutHeight)
+{
+	int32 Index;
+	FChunk& Chunk = FindOrAddChunk(X, Y, Index);
+	if (Chunk.States[Index] == EPointState::Unknown)
+	{
+		Chunk.States[Index] = TracePoint(X, Y, Chunk.Heights[Index]);
+	}
+
+	OutHeight = Chunk.Heights[Index];
+	return Chunk.States[Index];
+}
+
+UCombatGroundHeightGrid::EPointState UCombatGroundHeightGrid::TracePoint(int32 X, int32 Y, float& OutHeight) const
+{
+	OutHeight = 0.0f;
+
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return EPointState::Unknown;
+	}
+
+	const FVector Point(X * CellSize, Y * CellSize, 0.0);
+	FHitResult Hit;
+	if (!TraceDown(World, Point + FVector(0.0, 0.0, GroundTraceExtent), Point - FVector(0.0, 0.0, GroundTraceExtent), Hit))
+	{
+		return EPointState::NoGround;
+	}
+	OutHeight = Hit.ImpactPoint.Z;
+
+	// An edge, a wall top or a railing: a blend would smear it into the ground around it
+	if (Hit.ImpactNormal.Z < MinWalkableNormalZ)
+	{
+		return EPointState::Ambiguous;
+	}
+
+	// More ground underneath, e.g. below a bridge or an upper floor
+	const FVector BelowStart(Point.X, Point.Y, Hit.ImpactPoint.Z - GetDefault<UCombatNetworkSettings>()->GroundGridLevelSeparation);
+	FHitResult BelowHit;
+	if (TraceDown(World, BelowStart, Point - FVector(0.0, 0.0, GroundTraceExtent), BelowHit))
+	{
+		return EPointState::Ambiguous;
+	}
+
+	return EPointState::Ground;
+}
+
+UCombatGroundHeightGrid::FChunk& UCombatGroundHeightGrid::FindOrAddChunk(int32 X, int32 Y, int32& OutIndex)
+{
+	const FIntPoint Key(FMath::DivideAndRoundDown(X, ChunkSize), FMath::DivideAndRoundDown(Y, ChunkSize));
+	OutIndex = (Y - Key.Y * ChunkSize) * ChunkSize + (X - Key.X * ChunkSize);
+
+	TUniquePtr<FChunk>& Chunk = Chunks.FindOrAdd(Key);
+	if (!Chunk)
+	{
+		// Value-initialized, so every point starts out Unknown
+		Chunk = MakeUnique<FChunk>();
+	}
+	return *Chunk;
+}
+
+bool UCombatGroundHeightGrid::TraceGroundHeight(const UWorld* World, const FVector& Position, double& OutGroundZ)
+{
+	FHitResult Hit;
+	if (!World || !TraceDown(World, FVector(Position.X, Position.Y, GroundTraceExtent), FVector(Position.X, Position.Y, -GroundTraceExtent), Hit))
+	{
+		return false;
+	}
+
+	OutGroundZ = Hit.ImpactPoint.Z;
+	return true;
+}
+
+FString UCombatGroundHeightGrid::GetBakedPath() const
+{
+	// The same file for the level in the editor, in PIE and in a packaged game
+	const FString LevelName = FPackageName::GetShortName(UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName()));
+	return FPaths::ProjectContentDir() / TEXT("GroundHeights") / LevelName + TEXT(".bin");
+}
+
+bool UCombatGroundHeightGrid::Save() const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = GroundGridMagic;
+	int32 Version = GroundGridVersion;
+	float SavedCellSize = CellSize;
+	int32 NumChunks = Chunks.Num();
+	Writer << Magic << Version << SavedCellSize << NumChunks;
+
+	for (const TPair<FIntPoint, TUniquePtr<FChunk>>& Pair : Chunks)
+	{
+		FIntPoint Key = Pair.Key;
+		Writer << Key;
+		Writer.Serialize(Pair.Value->Heights, sizeof(FChunk::Heights));
+		Writer.Serialize(Pair.Value->States, sizeof(FChunk::States));
+	}
+
+	const FString Path = GetBakedPath();
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Couldn't write ground height grid to %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogCombatNetwork, Log, TEXT("Wrote %d ground height grid chunks to %s"), NumChunks, *Path);
+	return true;
+}
+
+bool UCombatGroundHeightGrid::Load()
+{
+	const FString Path = GetBakedPath();
+	TArray<uint8> Bytes;
+	if (!FPaths::FileExists(Path) || !FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		UE_LOG(LogCombatNetwork, Log, TEXT("No baked ground height grid at %s, building it as play needs it"), *Path);
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	float LoadedCellSize = 0.0f;
+	int32 NumChunks = 0;
+	Reader << Magic << Version << LoadedCellSize << NumChunks;
+
+	// Don't allocate for more chunks than the file can hold
+	constexpr int64 BytesPerChunk = sizeof(FIntPoint) + sizeof(FChunk::Heights) + sizeof(FChunk::States);
+	if (Reader.IsError() || Magic != GroundGridMagic || Version != GroundGridVersion || LoadedCellSize < 10.0f
+		|| NumChunks < 0 || NumChunks * BytesPerChunk > Reader.TotalSize() - Reader.Tell())
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Ignoring unreadable or outdated ground height grid %s"), *Path);
+		return false;
+	}
+
+	Chunks.Empty(NumChunks);
+	CellSize = LoadedCellSize;
+	for (int32 Index = 0; Index < NumChunks; ++Index)
+	{
+		FIntPoint Key;
+		Reader << Key;
+		TUniquePtr<FChunk> Chunk = MakeUnique<FChunk>();
+		Reader.Serialize(Chunk->Heights, sizeof(FChunk::Heights));
+		Reader.Serialize(Chunk->States, sizeof(FChunk::States));
+		Chunks.Add(Key, MoveTemp(Chunk));
+	}
+
+	UE_LOG(LogCombatNetwork, Log, TEXT("Loaded %d ground height grid chunks from %s"), NumChunks, *Path);
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace CombatGroundHeightGrid
+{
+	static void BuildGroundGrid(const TArray<FString>& Args, UWorld* World)
+	{
+		UCombatGroundHeightGrid* Grid = World ? World->GetSubsystem<UCombatGroundHeightGrid>() : nullptr;
+		if (!Grid)
+		{
+			UE_LOG(LogCombatNetwork, Warning, TEXT("This world has no ground height grid"));
+			return;
+		}
+
+		// Everything in the level, unless told otherwise. Only geometry that is loaded is traced
+		FBox2D Bounds;
+		if (Args.Num() >= 4)
+		{
+			Bounds = FBox2D(FVector2D(FCString::Atod(*Args[0]), FCString::Atod(*Args[1])), FVector2D(FCString::Atod(*Args[2]), FCString::Atod(*Args[3])));
+		}
+		else
+		{
+			const FBox LevelBounds = ALevelBounds::CalculateLevelBounds(World->PersistentLevel);
+			if (!LevelBounds.IsValid)
+			{
+				UE_LOG(LogCombatNetwork, Warning, TEXT("Level has no bounds; pass them as Combat.Net.BuildGroundGrid MinX MinY MaxX MaxY"));
+				return;
+			}
+			Bounds = FBox2D(FVector2D(LevelBounds.Min), FVector2D(LevelBounds.Max));
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		const int32 NumPoints = Grid->Build(Bounds);
+		UE_LOG(LogCombatNetwork, Log, TEXT("Traced %d ground height grid points in %.1f s"), NumPoints, FPlatformTime::Seconds() - StartTime);
+
+		Grid->Save();
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BuildGroundGridCommand(
+		TEXT("Combat.Net.BuildGroundGrid"),
+		TEXT("Traces the ground height grid of the current level and bakes it to Content/GroundHeights. Usage: Combat.Net.BuildGroundGrid [MinX MinY MaxX MaxY]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BuildGroundGrid));
+}
+
+#endif // !UE_BUILD_SHIPPING
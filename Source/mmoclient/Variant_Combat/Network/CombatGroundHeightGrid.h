@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatGroundHeightGrid.generated.h"
+
+/**
+ * Heights of a level's ground on a regular 2D grid, so placing a player doesn't take a trace
+ * through the whole level.
+ *
+ * Every grid point holds the height of the topmost level geometry above it, and a query blends
+ * the four points around it. Points are kept in square chunks, so the grid covers whatever part of
+ * the level play reaches without knowing its bounds. They are baked per level with the
+ * Combat.Net.BuildGroundGrid console command into Content/GroundHeights and loaded when play
+ * begins; points the bake didn't cover are traced the first time a query needs them.
+ *
+ * A query traces instead of blending where the blend can't be trusted: next to a point that is
+ * ambiguous, because there is more ground below its top surface (bridges, upper floors) or its
+ * surface is too steep to stand on, next to a point without ground, and where the four points'
+ * heights spread too far to be the same surface (steps, cliffs).
+ */
+UCLASS()
+class UCombatGroundHeightGrid : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/**
+	 * Finds the height of the ground under Position, from the grid where it can.
+	 * @return false if there's no ground under Position
+	 */
+	bool FindGroundHeight(const FVector& Position, double& OutGroundZ);
+
+	/**
+	 * Traces every grid point inside Bounds, replacing what the grid knew about them.
+	 * @return the number of points traced
+	 */
+	int32 Build(const FBox2D& Bounds);
+
+	/** Writes the grid to this level's baked grid file */
+	bool Save() const;
+
+	/** Replaces the grid with this level's baked grid file, if it has one */
+	bool Load();
+
+	/** Traces straight down through the whole level for the topmost level geometry under Position */
+	static bool TraceGroundHeight(const UWorld* World, const FVector& Position, double& OutGroundZ);
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** What is known about one grid point */
+	enum class EPointState : uint8
+	{
+		/** Not traced yet */
+		Unknown,
+		/** Single, walkable ground at the point's height */
+		Ground,
+		/** No level geometry under the point */
+		NoGround,
+		/** Ground whose height depends on more than X/Y; queries next to it trace */
+		Ambiguous
+	};
+
+	/** Points per side of a chunk */
+	static constexpr int32 ChunkSize = 32;
+
+	struct FChunk
+	{
+		float Heights[ChunkSize * ChunkSize];
+		EPointState States[ChunkSize * ChunkSize];
+	};
+
+	/** State and height of the point at grid coordinates X, Y, tracing it first if it's unknown */
+	EPointState FindOrTracePoint(int32 X, int32 Y, float& OutHeight);
+
+	/** Traces the ground at the point at grid coordinates X, Y */
+	EPointState TracePoint(int32 X, int32 Y, float& OutHeight) const;
+
+	/** Chunk holding the point at grid coordinates X, Y, and the point's index in it */
+	FChunk& FindOrAddChunk(int32 X, int32 Y, int32& OutIndex);
+
+	/** Where this level's grid is baked to */
+	FString GetBakedPath() const;
+
+	/** Distance between grid points */
+	float CellSize = 200.0f;
+
+	/** Chunks of points by chunk coordinates. Chunks come into existence the first time one of their points is needed */
+	TMap<FIntPoint, TUniquePtr<FChunk>> Chunks;
+};
@@ -0,0 +1,194 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTime.h"
+#include "Json.h"
+#include "CombatNetworkSubsystem.h"
+#include "CombatNetworkJson.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace CombatNetBenchmark
+{
+	/** A typical player_state frame, as sent by the server */
+	static const TCHAR* SamplePlayerState =
+		TEXT("{\"type\":\"player_state\",\"data\":{\"player_id\":\"3f2b9c1e-5a7d-4e8f-9b6a-1c2d3e4f5a6b\",")
+		TEXT("\"position\":[1234.5,-678.25,92.15],\"rotation\":[0.0,87.5,0.0],\"velocity\":[412.0,-36.5,0.0],")
+		TEXT("\"anim_state\":2,\"combo_stage\":1,\"charge_progress\":0.0,\"hp\":85.0,\"max_hp\":100.0,")
+		TEXT("\"timestamp\":1523.4167}}");
+
+	/** The decode the subsystem did before the streaming reader: DOM parse, then field lookups by name */
+	static bool DecodeWithDom(const FString& Message, FCombatNetworkState& OutState)
+	{
+		TSharedPtr<FJsonObject> JsonObject;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
+		if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+		{
+			return false;
+		}
+
+		FString MessageType;
+		if (!JsonObject->TryGetStringField(TEXT("type"), MessageType))
+		{
+			return false;
+		}
+
+		TSharedPtr<FJsonObject> Data = JsonObject->GetObjectField(TEXT("data"));
+		const FString PlayerId = Data->GetStringField(TEXT("player_id"));
+
+		const TArray<TSharedPtr<FJsonValue>>* PosArray;
+		if (Data->TryGetArrayField(TEXT("position"), PosArray) && PosArray->Num() >= 3)
+		{
+			OutState.Position.X = (*PosArray)[0]->AsNumber();
+			OutState.Position.Y = (*PosArray)[1]->AsNumber();
+			OutState.Position.Z = (*PosArray)[2]->AsNumber();
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* RotArray;
+		if (Data->TryGetArrayField(TEXT("rotation"), RotArray) && RotArray->Num() >= 3)
+		{
+			OutState.Rotation.Pitch = (*RotArray)[0]->AsNumber();
+			OutState.Rotation.Yaw = (*RotArray)[1]->AsNumber();
+			OutState.Rotation.Roll = (*RotArray)[2]->AsNumber();
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* VelArray;
+		if (Data->TryGetArrayField(TEXT("velocity"), VelArray) && VelArray->Num() >= 3)
+		{
+			OutState.Velocity.X = (*VelArray)[0]->AsNumber();
+			OutState.Velocity.Y = (*VelArray)[1]->AsNumber();
+			OutState.Velocity.Z = (*VelArray)[2]->AsNumber();
+		}
+
+		OutState.AnimState = static_cast<ECombatAnimationState>(Data->GetIntegerField(TEXT("anim_state")));
+		OutState.ComboStage = Data->GetIntegerField(TEXT("combo_stage"));
+		OutState.ChargeProgress = Data->GetNumberField(TEXT("charge_progress"));
+		OutState.CurrentHP = Data->GetNumberField(TEXT("hp"));
+		OutState.MaxHP = Data->GetNumberField(TEXT("max_hp"));
+		OutState.Timestamp = Data->GetNumberField(TEXT("timestamp"));
+		return !PlayerId.IsEmpty();
+	}
+
+	/** The pull reader straight into the message struct */
+	static bool DecodeUtf8(FUtf8StringView Message, FCombatNetworkState& OutState)
+	{
+		FUtf8StringView MessageType;
+		int32 Opcode;
+		FUtf8StringView Data;
+		FCombatPlayerStateMessage Decoded;
+		if (!FCombatJsonMessageDecoder::DecodeEnvelope(Message, MessageType, Opcode, Data)
+			|| !FCombatJsonMessageDecoder::DecodePlayerState(Data, Decoded))
+		{
+			return false;
+		}
+
+		OutState = Decoded.State;
+		return true;
+	}
+
+	/** The decode before raw frames: the socket's FString narrowed back to UTF-8 in a reused buffer, then the reader */
+	static bool DecodeWithReader(const FString& Message, TArray<UTF8CHAR>& Buffer, FCombatNetworkState& OutState)
+	{
+		const int32 Utf8Length = FPlatformString::ConvertedLength<UTF8CHAR>(*Message, Message.Len());
+		Buffer.SetNumUninitialized(Utf8Length, EAllowShrinking::No);
+		FPlatformString::Convert(Buffer.GetData(), Utf8Length, *Message, Message.Len());
+
+		return DecodeUtf8(FUtf8StringView(Buffer.GetData(), Utf8Length), OutState);
+	}
+
+	/** The current decode: the frame's UTF-8 bytes as received, never widened to an FString */
+	static bool DecodeRaw(const TArray<UTF8CHAR>& Frame, TArray<UTF8CHAR>& Buffer, FCombatNetworkState& OutState)
+	{
+		// Stands in for the copy into the pooled inbound frame
+		Buffer.Reset();
+		Buffer.Append(Frame);
+
+		return DecodeUtf8(FUtf8StringView(Buffer.GetData(), Buffer.Num()), OutState);
+	}
+
+	/**
+	 * Allocation calls made through GMalloc so far, or 0 in builds without stats.
+	 * The counters are process-wide, so other threads allocating meanwhile add a small fraction per message
+	 */
+	static uint64 GetAllocationCalls()
+	{
+#if UE_STATS
+		return FMalloc::TotalMallocCalls.load(std::memory_order_relaxed) + FMalloc::TotalReallocCalls.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+
+	/** Runs Decode Iterations times on the calling thread and reports the mean time and allocations per message */
+	template <typename DecodeFunc>
+	static void Measure(const TCHAR* Label, int32 Iterations, DecodeFunc&& Decode)
+	{
+		// Warm up caches and any lazily grown buffers before measuring
+		for (int32 Index = 0; Index < 64; ++Index)
+		{
+			Decode();
+		}
+
+		int32 Failures = 0;
+
+		const uint64 StartAllocations = GetAllocationCalls();
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < Iterations; ++Index)
+		{
+			Failures += Decode() ? 0 : 1;
+		}
+		const uint64 EndCycles = FPlatformTime::Cycles64();
+		const uint64 EndAllocations = GetAllocationCalls();
+
+		const double NsPerMessage = FPlatformTime::ToSeconds64(EndCycles - StartCycles) * 1.0e9 / Iterations;
+		const double AllocationsPerMessage = static_cast<double>(EndAllocations - StartAllocations) / Iterations;
+
+		UE_LOG(LogCombatNetwork, Display, TEXT("%-8s %9.1f ns/message  %7.2f allocs/message  (%d failed)"),
+			Label, NsPerMessage, AllocationsPerMessage, Failures);
+	}
+
+	static void RunDecodeBenchmark(const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+		const FString Message(SamplePlayerState);
+
+		TArray<UTF8CHAR> Buffer;
+		FCombatNetworkState State;
+
+		const int32 FrameLength = FPlatformString::ConvertedLength<UTF8CHAR>(*Message, Message.Len());
+		TArray<UTF8CHAR> Frame;
+		Frame.SetNumUninitialized(FrameLength);
+		FPlatformString::Convert(Frame.GetData(), FrameLength, *Message, Message.Len());
+
+		UE_LOG(LogCombatNetwork, Display, TEXT("Decoding player_state x%d (%d bytes)"), Iterations, Message.Len());
+#if !UE_STATS
+		UE_LOG(LogCombatNetwork, Display, TEXT("Allocation calls aren't counted in builds without stats and read as 0"));
+#endif
+
+		// Allocation calls are read from the allocator's own counters around each run, without touching
+		// the allocator. Each decoder's allocations on this thread are also tagged, so a run with
+		// -trace=memalloc,memtag (or -llm) breaks them down per decoder in Memory Insights
+		{
+			LLM_SCOPE_BYNAME(TEXT("CombatNet/Decode/DOM"));
+			Measure(TEXT("DOM"), Iterations, [&]() { return DecodeWithDom(Message, State); });
+		}
+		{
+			LLM_SCOPE_BYNAME(TEXT("CombatNet/Decode/Reader"));
+			Measure(TEXT("Reader"), Iterations, [&]() { return DecodeWithReader(Message, Buffer, State); });
+		}
+		{
+			LLM_SCOPE_BYNAME(TEXT("CombatNet/Decode/Raw"));
+			Measure(TEXT("Raw"), Iterations, [&]() { return DecodeRaw(Frame, Buffer, State); });
+		}
+	}
+
+	static FAutoConsoleCommand DecodeBenchmarkCommand(
+		TEXT("Combat.Net.BenchmarkDecode"),
+		TEXT("Compares the DOM decoder, the streaming reader and the raw UTF-8 path on a sample player_state. Reports time and allocation calls per message; allocations are also tagged CombatNet/Decode/* for Memory Insights. Usage: Combat.Net.BenchmarkDecode [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunDecodeBenchmark));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkClock.h"
+#include "Algo/Sort.h"
+
+namespace
+{
+	/** Probes sent in quick succession after a reset, and the time between them */
+	constexpr int32 BurstProbes = 5;
+	constexpr double BurstInterval = 0.2;
+
+	/** Round trips longer than this are not worth estimating from */
+	constexpr double MaxRoundTripTime = 2.0;
+
+	/** Largest change applied to the offset per sample, and the error beyond which it snaps instead */
+	constexpr double MaxSlewPerSample = 0.005;
+	constexpr double SnapThreshold = 0.25;
+}
+
+void FCombatClockSync::Reset()
+{
+	NumSamples = 0;
+	NextSample = 0;
+	NumAnswered = 0;
+	Offset = 0.0;
+	TargetOffset = 0.0;
+	RoundTripTime = 0.0;
+	Jitter = 0.0;
+	LastProbeTime = -UE_BIG_NUMBER;
+}
+
+bool FCombatClockSync::ShouldProbe(double LocalTime) const
+{
+	const double Interval = NumAnswered < BurstProbes ? BurstInterval : ProbeInterval;
+	return LocalTime - LastProbeTime >= Interval;
+}
+
+void FCombatClockSync::NotifyProbeSent(double LocalTime)
+{
+	LastProbeTime = LocalTime;
+}
+
+bool FCombatClockSync::AddSample(double ClientSendTime, double ServerTime, double LocalReceiveTime)
+{
+	const double Sample = LocalReceiveTime - ClientSendTime;
+	if (Sample < 0.0 || Sample > MaxRoundTripTime)
+	{
+		return false;
+	}
+
+	FSample& Slot = Samples[NextSample];
+	Slot.RoundTripTime = Sample;
+	Slot.Offset = ServerTime + Sample * 0.5 - LocalReceiveTime;
+	NextSample = (NextSample + 1) % MaxSamples;
+	NumSamples = FMath::Min(NumSamples + 1, MaxSamples);
+	++NumAnswered;
+
+	Estimate();
+
+	const double Error = TargetOffset - Offset;
+	if (NumAnswered == 1 || FMath::Abs(Error) > SnapThreshold)
+	{
+		Offset = TargetOffset;
+	}
+	else
+	{
+		Offset += FMath::Clamp(Error, -MaxSlewPerSample, MaxSlewPerSample);
+	}
+
+	return true;
+}
+
+void FCombatClockSync::Estimate()
+{
+	FSample Sorted[MaxSamples];
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		Sorted[Index] = Samples[Index];
+	}
+
+	Algo::Sort(TArrayView<FSample>(Sorted, NumSamples), [](const FSample& A, const FSample& B)
+	{
+		return A.RoundTripTime < B.RoundTripTime;
+	});
+
+	RoundTripTime = Sorted[NumSamples / 2].RoundTripTime;
+
+	double Deviation = 0.0;
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		Deviation += FMath::Abs(Sorted[Index].RoundTripTime - RoundTripTime);
+	}
+	Jitter = Deviation / NumSamples;
+
+	// The fastest half of the probes saw the least queuing, so their offsets are the most symmetric
+	const int32 NumTrusted = FMath::Max(NumSamples / 2, 1);
+	double OffsetSum = 0.0;
+	for (int32 Index = 0; Index < NumTrusted; ++Index)
+	{
+		OffsetSum += Sorted[Index].Offset;
+	}
+	TargetOffset = OffsetSum / NumTrusted;
+}
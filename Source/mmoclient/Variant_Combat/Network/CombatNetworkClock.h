@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Estimates the server clock from ping/pong probes.
+ *
+ * Each probe yields a round trip time and an offset between the server's clock and ours, assuming
+ * the server answered halfway through the round trip. Queuing delays make that assumption wrong
+ * by up to half the extra delay, so only the probes with the shortest round trips in the recent
+ * window contribute to the offset, and a single delayed probe can't move it.
+ *
+ * The offset used for GetServerTime slews towards new estimates by a few milliseconds per probe,
+ * so the shared timeline never jumps backwards under interpolation. It only snaps on the first
+ * estimate or when the error is too large to slew away.
+ */
+class FCombatClockSync
+{
+public:
+
+	/** Probes considered for each estimate */
+	static constexpr int32 MaxSamples = 16;
+
+	/** Forgets every probe and estimate, e.g. for a new connection */
+	void Reset();
+
+	/** Sets the time between probes once the estimate has settled, in seconds */
+	void SetProbeInterval(double InProbeInterval) { ProbeInterval = InProbeInterval; }
+
+	/** Whether a probe should be sent at LocalTime. Probes are sent in quick succession until the first estimate has settled */
+	bool ShouldProbe(double LocalTime) const;
+
+	/** Records that a probe was sent at LocalTime */
+	void NotifyProbeSent(double LocalTime);
+
+	/**
+	 * Adds the answer to a probe sent at ClientSendTime, stamped by the server at ServerTime and received at LocalReceiveTime.
+	 * @return false if the sample was rejected as implausible
+	 */
+	bool AddSample(double ClientSendTime, double ServerTime, double LocalReceiveTime);
+
+	/** Whether at least one probe has been answered */
+	bool IsSynchronized() const { return NumSamples > 0; }
+
+	/** Server time at LocalTime. Equal to LocalTime until synchronized */
+	double GetServerTime(double LocalTime) const { return LocalTime + Offset; }
+
+	/** Median round trip time of recent probes, in seconds */
+	double GetRoundTripTime() const { return RoundTripTime; }
+
+	/** Mean deviation of recent round trip times from the median, in seconds */
+	double GetJitter() const { return Jitter; }
+
+private:
+
+	/** Re-derives the target offset, round trip time and jitter from the sample window */
+	void Estimate();
+
+	struct FSample
+	{
+		double RoundTripTime = 0.0;
+		double Offset = 0.0;
+	};
+
+	/** Ring of the most recent samples */
+	FSample Samples[MaxSamples];
+	int32 NumSamples = 0;
+	int32 NextSample = 0;
+
+	/** Probes answered since the last reset, for the quick initial burst */
+	int32 NumAnswered = 0;
+
+	/** Offset GetServerTime uses, and the estimate it is slewing towards */
+	double Offset = 0.0;
+	double TargetOffset = 0.0;
+
+	double RoundTripTime = 0.0;
+	double Jitter = 0.0;
+
+	double ProbeInterval = 2.0;
+	double LastProbeTime = -UE_BIG_NUMBER;
+};
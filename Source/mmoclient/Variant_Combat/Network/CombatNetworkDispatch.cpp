@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkDispatch.h"
+#include "Misc/ScopeRWLock.h"
+
+namespace
+{
+	/** Initial bucket count. Comfortably fits the built-in message types at half load */
+	constexpr int32 InitialBucketCount = 32;
+}
+
+int32 FCombatMessageDispatcher::RegisterHandler(FUtf8StringView Type, FCombatNetworkMessageHandler Handler)
+{
+	// Raw handlers get the data text on the game thread; the frame it points into is still alive then
+	FCombatInboundMessageHandler RawHandler = FCombatInboundMessageHandler::CreateLambda(
+		[Handler = MoveTemp(Handler)](const FCombatInboundMessage& Message)
+		{
+			Handler.ExecuteIfBound(Message.Data);
+		});
+
+	FWriteScopeLock WriteLock(Lock);
+	return Register(Type, nullptr, MoveTemp(RawHandler));
+}
+
+int32 FCombatMessageDispatcher::RegisterDecodedHandler(FUtf8StringView Type, FCombatMessageDecodeFunc Decode, FCombatInboundMessageHandler Handler)
+{
+	FWriteScopeLock WriteLock(Lock);
+	return Register(Type, Decode, MoveTemp(Handler));
+}
+
+int32 FCombatMessageDispatcher::Register(FUtf8StringView Type, FCombatMessageDecodeFunc Decode, FCombatInboundMessageHandler&& Handler)
+{
+	if (Type.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	// Keep the table at most half full so probe sequences stay short
+	if ((Entries.Num() + 1) * 2 > Buckets.Num())
+	{
+		GrowBuckets();
+	}
+
+	const uint32 Hash = HashTypeName(Type);
+	const int32 Bucket = FindBucket(Type, Hash);
+
+	if (Buckets[Bucket] != INDEX_NONE)
+	{
+		// Already interned: rebind if the previous handler was unregistered
+		FEntry& Existing = Entries[Buckets[Bucket]];
+		if (Existing.Handler.IsValid() && Existing.Handler->IsBound())
+		{
+			return INDEX_NONE;
+		}
+
+		Existing.Decode = Decode;
+		Existing.Handler = MakeShared<FCombatInboundMessageHandler>(MoveTemp(Handler));
+		return Buckets[Bucket];
+	}
+
+	const int32 Opcode = Entries.AddDefaulted();
+	FEntry& Entry = Entries[Opcode];
+	Entry.Name.Append(Type.GetData(), Type.Len());
+	Entry.Hash = Hash;
+	Entry.Decode = Decode;
+	Entry.Handler = MakeShared<FCombatInboundMessageHandler>(MoveTemp(Handler));
+
+	Buckets[Bucket] = Opcode;
+	return Opcode;
+}
+
+void FCombatMessageDispatcher::UnregisterHandler(int32 Opcode)
+{
+	FWriteScopeLock WriteLock(Lock);
+	if (Entries.IsValidIndex(Opcode))
+	{
+		Entries[Opcode].Decode = nullptr;
+		Entries[Opcode].Handler.Reset();
+	}
+}
+
+int32 FCombatMessageDispatcher::FindOpcode(FUtf8StringView Type) const
+{
+	FReadScopeLock ReadLock(Lock);
+	if (Buckets.Num() == 0 || Type.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	return Buckets[FindBucket(Type, HashTypeName(Type))];
+}
+
+FUtf8StringView FCombatMessageDispatcher::GetTypeName(int32 Opcode) const
+{
+	if (!Entries.IsValidIndex(Opcode))
+	{
+		return FUtf8StringView();
+	}
+
+	return FUtf8StringView(Entries[Opcode].Name.GetData(), Entries[Opcode].Name.Num());
+}
+
+bool FCombatMessageDispatcher::Decode(int32 Opcode, FUtf8StringView Data, FCombatInboundMessage& OutMessage) const
+{
+	FCombatMessageDecodeFunc DecodeFunc = nullptr;
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (!Entries.IsValidIndex(Opcode))
+		{
+			return false;
+		}
+		DecodeFunc = Entries[Opcode].Decode;
+	}
+
+	OutMessage.Opcode = Opcode;
+	OutMessage.Data = Data;
+	return !DecodeFunc || DecodeFunc(Data, OutMessage);
+}
+
+bool FCombatMessageDispatcher::Dispatch(const FCombatInboundMessage& Message) const
+{
+	if (!Entries.IsValidIndex(Message.Opcode))
+	{
+		return false;
+	}
+
+	// Held by reference count rather than copied, so dispatching doesn't allocate
+	const TSharedPtr<FCombatInboundMessageHandler> Handler = Entries[Message.Opcode].Handler;
+	return Handler.IsValid() && Handler->ExecuteIfBound(Message);
+}
+
+uint32 FCombatMessageDispatcher::HashTypeName(FUtf8StringView Type)
+{
+	uint32 Hash = 2166136261u;
+	for (const UTF8CHAR Char : Type)
+	{
+		Hash = (Hash ^ static_cast<uint8>(Char)) * 16777619u;
+	}
+	return Hash;
+}
+
+int32 FCombatMessageDispatcher::FindBucket(FUtf8StringView Type, uint32 Hash) const
+{
+	const int32 Mask = Buckets.Num() - 1;
+	int32 Bucket = static_cast<int32>(Hash & static_cast<uint32>(Mask));
+
+	// Linear probing. The table is never full, so this always reaches an empty bucket
+	while (Buckets[Bucket] != INDEX_NONE)
+	{
+		const FEntry& Entry = Entries[Buckets[Bucket]];
+		if (Entry.Hash == Hash && FUtf8StringView(Entry.Name.GetData(), Entry.Name.Num()).Equals(Type, ESearchCase::CaseSensitive))
+		{
+			break;
+		}
+		Bucket = (Bucket + 1) & Mask;
+	}
+
+	return Bucket;
+}
+
+void FCombatMessageDispatcher::GrowBuckets()
+{
+	const int32 NewCount = Buckets.Num() > 0 ? Buckets.Num() * 2 : InitialBucketCount;
+	Buckets.Init(INDEX_NONE, NewCount);
+
+	const int32 Mask = NewCount - 1;
+	for (int32 Opcode = 0; Opcode < Entries.Num(); ++Opcode)
+	{
+		int32 Bucket = static_cast<int32>(Entries[Opcode].Hash & static_cast<uint32>(Mask));
+		while (Buckets[Bucket] != INDEX_NONE)
+		{
+			Bucket = (Bucket + 1) & Mask;
+		}
+		Buckets[Bucket] = Opcode;
+	}
+}
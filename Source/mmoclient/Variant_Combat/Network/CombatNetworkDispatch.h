@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatNetworkMessages.h"
+
+/**
+ * Handler for one type of server message. Receives the raw JSON text of the message's "data"
+ * field, which can be read with FCombatJsonReader. The view is only valid for the duration of the call.
+ */
+DECLARE_DELEGATE_OneParam(FCombatNetworkMessageHandler, FUtf8StringView /* Data */);
+
+/**
+ * Game thread handler for a message that was decoded on the decode worker
+ */
+DECLARE_DELEGATE_OneParam(FCombatInboundMessageHandler, const FCombatInboundMessage& /* Message */);
+
+/**
+ * Decodes a message's data text into the payload of OutMessage.
+ * Runs on the decode worker, so it must only read its arguments.
+ */
+using FCombatMessageDecodeFunc = bool (*)(FUtf8StringView Data, FCombatInboundMessage& OutMessage);
+
+/**
+ * Interned table of server message types.
+ *
+ * Each registered wire type name is assigned a small integer opcode once, and handlers live in an
+ * array indexed by that opcode. A type name is resolved with a single hash probe and no
+ * allocation, and servers that were sent the opcode table in the join handshake can skip the name
+ * entirely and address handlers by opcode.
+ *
+ * Opcodes stay stable for the lifetime of the dispatcher, also across unregistration, so they can
+ * be advertised to the server at connect time.
+ *
+ * Registration and Dispatch are game thread only. FindOpcode and Decode may be called from the
+ * decode worker concurrently with registration. Handlers may register and unregister types,
+ * including their own, while they are being dispatched.
+ */
+class FCombatMessageDispatcher
+{
+public:
+
+	/**
+	 * Interns Type and binds a handler that reads the raw data text on the game thread.
+	 * @return the type's opcode, or INDEX_NONE if another handler is already bound to it
+	 */
+	int32 RegisterHandler(FUtf8StringView Type, FCombatNetworkMessageHandler Handler);
+
+	/**
+	 * Interns Type and binds a decoder that runs on the decode worker, and a handler that receives its result on the game thread.
+	 * @return the type's opcode, or INDEX_NONE if another handler is already bound to it
+	 */
+	int32 RegisterDecodedHandler(FUtf8StringView Type, FCombatMessageDecodeFunc Decode, FCombatInboundMessageHandler Handler);
+
+	/** Unbinds the handler of Opcode. The opcode itself stays reserved for the same type */
+	void UnregisterHandler(int32 Opcode);
+
+	/** Resolves a wire type name to its opcode, or INDEX_NONE if it has never been registered */
+	int32 FindOpcode(FUtf8StringView Type) const;
+
+	/** Returns the wire type name of Opcode, or an empty view if it is out of range */
+	FUtf8StringView GetTypeName(int32 Opcode) const;
+
+	/**
+	 * Runs the decoder registered for Opcode, if any, and fills in OutMessage's opcode and data.
+	 * @return false if the opcode is unknown or its decoder rejected the data
+	 */
+	bool Decode(int32 Opcode, FUtf8StringView Data, FCombatInboundMessage& OutMessage) const;
+
+	/**
+	 * Invokes the handler bound to the message's opcode.
+	 * @return false if the opcode is unknown or has no bound handler
+	 */
+	bool Dispatch(const FCombatInboundMessage& Message) const;
+
+	/** Number of opcodes assigned so far. Valid opcodes are [0, Num()) */
+	int32 Num() const { return Entries.Num(); }
+
+private:
+
+	struct FEntry
+	{
+		/** Wire type name, UTF-8 without terminator */
+		TArray<UTF8CHAR> Name;
+
+		/** Hash of Name, kept to avoid rehashing when the bucket table grows */
+		uint32 Hash = 0;
+
+		/** Decoder run on the worker, or null for handlers that read the raw data themselves */
+		FCombatMessageDecodeFunc Decode = nullptr;
+
+		/** Shared so a dispatch in progress keeps its handler alive if it is unbound or the entries reallocate */
+		TSharedPtr<FCombatInboundMessageHandler> Handler;
+	};
+
+	/** Interns Type and binds Decode and Handler to it. Expects the write lock to be held */
+	int32 Register(FUtf8StringView Type, FCombatMessageDecodeFunc Decode, FCombatInboundMessageHandler&& Handler);
+
+	/** FNV-1a over the type name's bytes */
+	static uint32 HashTypeName(FUtf8StringView Type);
+
+	/** Returns the bucket holding Type, or the empty bucket it would be inserted into */
+	int32 FindBucket(FUtf8StringView Type, uint32 Hash) const;
+
+	/** Doubles the bucket table and reinserts every entry */
+	void GrowBuckets();
+
+	/** Registered types, indexed by opcode */
+	TArray<FEntry> Entries;
+
+	/** Open-addressed hash table of opcodes, INDEX_NONE for empty buckets. Size is always a power of two */
+	TArray<int32> Buckets;
+
+	/** Guards Entries and Buckets against registration while the decode worker reads them */
+	mutable FRWLock Lock;
+};
@@ -0,0 +1,59 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "CombatNetworkDispatch.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatNetDispatchReentrancyTest, "Combat.Net.DispatchReentrancy",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCombatNetDispatchReentrancyTest::RunTest(const FString& Parameters)
+{
+	FCombatMessageDispatcher Dispatcher;
+
+	int32 KickOpcode = INDEX_NONE;
+	int32 LateOpcode = INDEX_NONE;
+	int32 NumLateHandled = 0;
+
+	// Only the handler's captures tell whether it survived its own unregistration
+	const FString Marker(TEXT("still alive"));
+	FString MarkerSeen;
+
+	KickOpcode = Dispatcher.RegisterDecodedHandler(UTF8TEXTVIEW("kick"), nullptr,
+		FCombatInboundMessageHandler::CreateLambda([&Dispatcher, &KickOpcode, &LateOpcode, &NumLateHandled, &MarkerSeen, Marker](const FCombatInboundMessage&)
+		{
+			// Enough new types to outgrow the entries the running handler is stored in
+			for (int32 Index = 0; Index < 64; ++Index)
+			{
+				const FTCHARToUTF8 Type(*FString::Printf(TEXT("filler_%d"), Index));
+				Dispatcher.RegisterDecodedHandler(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Type.Get()), Type.Length()), nullptr, FCombatInboundMessageHandler());
+			}
+			LateOpcode = Dispatcher.RegisterDecodedHandler(UTF8TEXTVIEW("late"), nullptr,
+				FCombatInboundMessageHandler::CreateLambda([&NumLateHandled](const FCombatInboundMessage&) { ++NumLateHandled; }));
+
+			Dispatcher.UnregisterHandler(KickOpcode);
+
+			MarkerSeen = Marker;
+		}));
+
+	FCombatInboundMessage Message;
+	Message.Opcode = KickOpcode;
+	TestTrue(TEXT("Handler dispatched"), Dispatcher.Dispatch(Message));
+	TestEqual(TEXT("Handler ran to completion after unregistering itself"), MarkerSeen, Marker);
+
+	TestFalse(TEXT("Unregistered handler no longer dispatched"), Dispatcher.Dispatch(Message));
+
+	Message.Opcode = LateOpcode;
+	TestTrue(TEXT("Type registered from a handler dispatched"), LateOpcode != INDEX_NONE && Dispatcher.Dispatch(Message));
+	TestEqual(TEXT("Type registered from a handler handled"), NumLateHandled, 1);
+
+	// The opcode stays reserved, so the type can be bound again
+	TestEqual(TEXT("Rebound to the same opcode"), Dispatcher.RegisterDecodedHandler(UTF8TEXTVIEW("kick"), nullptr,
+		FCombatInboundMessageHandler::CreateLambda([](const FCombatInboundMessage&) {})), KickOpcode);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,432 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkInbound.h"
+#include "CombatNetworkDispatch.h"
+#include "CombatNetworkJson.h"
+#include "CombatNetworkSubsystem.h"
+
+FCombatInboundPipeline::FCombatInboundPipeline(const FCombatMessageDispatcher& InDispatcher)
+	: Dispatcher(InDispatcher)
+	, DecodePipe(TEXT("CombatNetworkDecode"))
+{
+	JoinResponseOpcode = Dispatcher.FindOpcode(UTF8TEXTVIEW("join_response"));
+	PlayerJoinedOpcode = Dispatcher.FindOpcode(UTF8TEXTVIEW("player_joined"));
+	PlayerLeftOpcode = Dispatcher.FindOpcode(UTF8TEXTVIEW("player_left"));
+	PlayerStateOpcode = Dispatcher.FindOpcode(UTF8TEXTVIEW("player_state"));
+	StateAckOpcode = Dispatcher.FindOpcode(UTF8TEXTVIEW("state_ack"));
+	WorldSnapshotOpcode = Dispatcher.FindOpcode(UTF8TEXTVIEW("world_snapshot"));
+}
+
+FCombatInboundPipeline::~FCombatInboundPipeline()
+{
+	DecodePipe.WaitUntilEmpty();
+}
+
+void FCombatInboundPipeline::EnqueueText(const uint8* Data, int32 Size)
+{
+	Enqueue(Data, Size, false);
+}
+
+void FCombatInboundPipeline::EnqueueBinary(const uint8* Data, int32 Size)
+{
+	Enqueue(Data, Size, true);
+}
+
+FCombatInboundFrame* FCombatInboundPipeline::Dequeue()
+{
+	while (FCombatInboundFrame* Frame = DecodedFrames.Pop())
+	{
+		--NumPending;
+
+		if (Frame->Generation == Generation)
+		{
+			return Frame;
+		}
+
+		// Received before the last reset; its connection is gone
+		Release(Frame);
+	}
+
+	return nullptr;
+}
+
+void FCombatInboundPipeline::Release(FCombatInboundFrame* Frame)
+{
+	FreeFrames.Add(Frame);
+}
+
+void FCombatInboundPipeline::Reset()
+{
+	++Generation;
+
+	// Ordered after every frame already launched, so none of them sees the cleared state
+	DecodePipe.Launch(TEXT("CombatNetworkDecodeReset"), [this]()
+	{
+		ZoneOrigin = FVector::ZeroVector;
+		bNetIds = false;
+		NetIdStateBaselines.Empty();
+		RemoteStateBaselines.Empty();
+
+		// The next connection only acknowledges once its join_response, decoded after this, has been handled
+		FScopeLock Lock(&StateAckLock);
+		PendingStateAcks.Reset();
+		PendingStateAckIndicesByNetId.Reset();
+		PendingStateAckIndicesById.Reset();
+	});
+}
+
+void FCombatInboundPipeline::ForgetPlayer(const FString& PlayerId)
+{
+	DecodePipe.Launch(TEXT("CombatNetworkDecodeForget"), [this, PlayerId]()
+	{
+		RemoteStateBaselines.Remove(PlayerId);
+		RemoveStateAck(CombatNetProtocol::InvalidNetId, PlayerId);
+	});
+}
+
+void FCombatInboundPipeline::TakeStateAcks(TArray<FCombatRemoteStateAck>& OutAcks)
+{
+	OutAcks.Reset();
+
+	// Swapping hands both arrays' allocations back and forth instead of reallocating every tick
+	FScopeLock Lock(&StateAckLock);
+	Swap(OutAcks, PendingStateAcks);
+	PendingStateAckIndicesByNetId.Reset();
+	PendingStateAckIndicesById.Reset();
+}
+
+void FCombatInboundPipeline::WaitForDecode()
+{
+	DecodePipe.WaitUntilEmpty();
+}
+
+FCombatInboundFrame* FCombatInboundPipeline::AcquireFrame()
+{
+	if (FreeFrames.Num() == 0)
+	{
+		FreeFrames.Add(AllFrames.Add_GetRef(MakeUnique<FCombatInboundFrame>()).Get());
+	}
+
+	FCombatInboundFrame* Frame = FreeFrames.Pop(EAllowShrinking::No);
+	Frame->Generation = Generation;
+	Frame->Message.Opcode = INDEX_NONE;
+	Frame->Message.Data = FUtf8StringView();
+	Frame->Message.Snapshot = &Frame->Snapshot;
+	Frame->Message.Strings = &Frame->Strings;
+	return Frame;
+}
+
+void FCombatInboundPipeline::Enqueue(const uint8* Data, int32 Size, bool bIsBinary)
+{
+	FCombatInboundFrame* Frame = AcquireFrame();
+	Frame->bIsBinary = bIsBinary;
+	Frame->Message.ReceiveTime = FPlatformTime::Seconds();
+
+	// Reset keeps the pooled buffer's capacity, so steady-state frames copy without allocating
+	Frame->Bytes.Reset();
+	Frame->Bytes.Append(Data, Size);
+
+	++NumPending;
+
+	DecodePipe.Launch(TEXT("CombatNetworkDecodeFrame"), [this, Frame]()
+	{
+		DecodeFrame(*Frame);
+		DecodedFrames.Push(Frame);
+	});
+}
+
+void FCombatInboundPipeline::DecodeFrame(FCombatInboundFrame& Frame)
+{
+	if (Frame.bIsBinary)
+	{
+		DecodeBinaryFrame(Frame);
+	}
+	else
+	{
+		DecodeTextFrame(Frame);
+	}
+}
+
+void FCombatInboundPipeline::DecodeTextFrame(FCombatInboundFrame& Frame)
+{
+	const FUtf8StringView Text(reinterpret_cast<const UTF8CHAR*>(Frame.Bytes.GetData()), Frame.Bytes.Num());
+
+	// Pull the type and the raw data text out of the envelope without building a JSON DOM
+	FUtf8StringView MessageType;
+	int32 Opcode;
+	FUtf8StringView Data;
+	if (!FCombatJsonMessageDecoder::DecodeEnvelope(Text, MessageType, Opcode, Data))
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Failed to parse message: %s"), *FString(Text));
+		return;
+	}
+
+	// Servers that know our opcode table send "op"; anything else is resolved by name
+	if (Opcode == INDEX_NONE)
+	{
+		Opcode = Dispatcher.FindOpcode(MessageType);
+	}
+
+	// Decoded strings are never longer than their source, so this is all the room they can take
+	Frame.Strings.Reset();
+	Frame.Strings.Reserve(Frame.Bytes.Num());
+
+	if (!Dispatcher.Decode(Opcode, Data, Frame.Message))
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Unknown or malformed message: %s (op %d)"), *FString(MessageType), Opcode);
+		Frame.Message.Opcode = INDEX_NONE;
+		return;
+	}
+
+	// Deltas that follow in this stream are quantized against the zone origin from the handshake,
+	// and name their players by net id if the server assigned us one
+	if (Opcode == JoinResponseOpcode)
+	{
+		const FCombatJoinResponseMessage& JoinResponse = Frame.Message.Get<FCombatJoinResponseMessage>();
+		ZoneOrigin = JoinResponse.ZoneOrigin;
+		bNetIds = JoinResponse.NetId != CombatNetProtocol::InvalidNetId;
+	}
+
+	// Net ids are reused, so whoever had this one before can't leave baselines for its next player
+	else if (Opcode == PlayerJoinedOpcode)
+	{
+		ForgetNetId(Frame.Message.Get<FCombatPlayerJoinedMessage>().NetId);
+	}
+	else if (Opcode == PlayerLeftOpcode)
+	{
+		ForgetNetId(Frame.Message.Get<FCombatPlayerLeftMessage>().NetId);
+	}
+}
+
+void FCombatInboundPipeline::DecodeBinaryFrame(FCombatInboundFrame& Frame)
+{
+	const int32 Size = Frame.Bytes.Num();
+	FCombatByteReader Reader(Frame.Bytes.GetData(), Size);
+
+	ECombatBinaryOpcode Opcode;
+	if (!FCombatNetworkCodec::ReadHeader(Reader, Opcode))
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Dropping malformed binary frame (%d bytes)"), Size);
+		return;
+	}
+
+	switch (Opcode)
+	{
+		case ECombatBinaryOpcode::PlayerStateDelta:
+		{
+			FCombatPlayerStateMessage& Decoded = Frame.Message.Emplace<FCombatPlayerStateMessage>();
+			if (DecodePlayerStateDelta(Reader, Decoded))
+			{
+				Frame.Message.Opcode = PlayerStateOpcode;
+			}
+			break;
+		}
+
+		case ECombatBinaryOpcode::StateAck:
+		{
+			FCombatStateAckMessage& Decoded = Frame.Message.Emplace<FCombatStateAckMessage>();
+			Decoded.Sequence = Reader.ReadUInt16();
+			if (!Reader.HasError())
+			{
+				Frame.Message.Opcode = StateAckOpcode;
+			}
+			break;
+		}
+
+		case ECombatBinaryOpcode::WorldSnapshot:
+		{
+			FCombatNetworkCodec::ReadWorldSnapshot(Reader, *Frame.Message.Snapshot, bNetIds);
+			if (Reader.HasError())
+			{
+				UE_LOG(LogCombatNetwork, Warning, TEXT("Truncated binary world_snapshot (%d bytes)"), Size);
+				break;
+			}
+
+			Frame.Message.Opcode = WorldSnapshotOpcode;
+			break;
+		}
+
+		case ECombatBinaryOpcode::PlayerState:
+		{
+			FCombatPlayerStateMessage& Decoded = Frame.Message.Emplace<FCombatPlayerStateMessage>();
+			ReadPlayer(Reader, Decoded);
+			FCombatNetworkCodec::ReadState(Reader, Decoded.State);
+
+			if (Reader.HasError())
+			{
+				UE_LOG(LogCombatNetwork, Warning, TEXT("Truncated binary player_state (%d bytes)"), Size);
+				break;
+			}
+
+			Frame.Message.Opcode = PlayerStateOpcode;
+			break;
+		}
+
+		default:
+			UE_LOG(LogCombatNetwork, Warning, TEXT("Unknown binary opcode: %d"), static_cast<int32>(Opcode));
+			break;
+	}
+}
+
+bool FCombatInboundPipeline::DecodePlayerStateDelta(FCombatByteReader& Reader, FCombatPlayerStateMessage& OutMessage)
+{
+	const uint16 Sequence = Reader.ReadUInt16();
+	ReadPlayer(Reader, OutMessage);
+	const uint8 BaselineAge = Reader.ReadUInt8();
+
+	if (Reader.HasError())
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Truncated binary player_state delta header"));
+		return false;
+	}
+
+	FCombatStateHistory* Baselines = FindOrAddBaselines(OutMessage);
+	if (!Baselines)
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Net id %u out of range, dropping delta %d"), OutMessage.NetId, Sequence);
+		return false;
+	}
+
+	// Age 0 means the server sent the full state (delta against zero)
+	static const FCombatQuantizedState ZeroBaseline;
+	const FCombatQuantizedState* Baseline = &ZeroBaseline;
+	if (BaselineAge > 0)
+	{
+		Baseline = Baselines->Find(static_cast<uint16>(Sequence - BaselineAge));
+		if (!Baseline)
+		{
+			// The server referenced a baseline we no longer have; wait for the next full state
+			UE_LOG(LogCombatNetwork, Warning, TEXT("Missing baseline %d for %s/%u, dropping delta %d"),
+				static_cast<uint16>(Sequence - BaselineAge), *FString(OutMessage.PlayerId), OutMessage.NetId, Sequence);
+			return false;
+		}
+	}
+
+	FCombatQuantizedState Quantized;
+	FCombatNetworkCodec::ReadStateDelta(Reader, *Baseline, Quantized);
+
+	if (Reader.HasError())
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Truncated binary player_state delta for %s/%u"), *FString(OutMessage.PlayerId), OutMessage.NetId);
+		return false;
+	}
+
+	// Remember this state as a future baseline and acknowledge it in the next network tick
+	Baselines->Store(Sequence, Quantized);
+	AddStateAck(OutMessage, Sequence);
+
+	Quantized.Dequantize(ZoneOrigin, OutMessage.State);
+	return true;
+}
+
+void FCombatInboundPipeline::ReadPlayer(FCombatByteReader& Reader, FCombatPlayerStateMessage& OutMessage) const
+{
+	if (bNetIds)
+	{
+		OutMessage.NetId = Reader.ReadVarUInt32();
+	}
+	else
+	{
+		OutMessage.PlayerId = Reader.ReadString();
+	}
+}
+
+FCombatStateHistory* FCombatInboundPipeline::FindOrAddBaselines(const FCombatPlayerStateMessage& Message)
+{
+	if (!bNetIds)
+	{
+		return &RemoteStateBaselines.FindOrAdd(FString(Message.PlayerId));
+	}
+
+	const uint32 NetId = Message.NetId;
+	if (NetId == CombatNetProtocol::InvalidNetId || NetId > CombatNetProtocol::MaxNetId)
+	{
+		return nullptr;
+	}
+
+	if (NetId >= static_cast<uint32>(NetIdStateBaselines.Num()))
+	{
+		NetIdStateBaselines.SetNum(NetId + 1);
+	}
+	return &NetIdStateBaselines[NetId];
+}
+
+void FCombatInboundPipeline::ForgetNetId(uint32 NetId)
+{
+	if (NetId == CombatNetProtocol::InvalidNetId)
+	{
+		return;
+	}
+
+	const int32 Index = static_cast<int32>(NetId);
+	if (NetIdStateBaselines.IsValidIndex(Index))
+	{
+		NetIdStateBaselines[Index].Reset();
+	}
+
+	// An ack still waiting would name a sequence of the previous player to the next one
+	RemoveStateAck(NetId, FString());
+}
+
+void FCombatInboundPipeline::AddStateAck(const FCombatPlayerStateMessage& Message, uint16 Sequence)
+{
+	const FString PlayerId(Message.PlayerId);
+
+	FScopeLock Lock(&StateAckLock);
+
+	int32* Index = bNetIds ? PendingStateAckIndicesByNetId.Find(Message.NetId) : PendingStateAckIndicesById.Find(PlayerId);
+	if (!Index)
+	{
+		const int32 NewIndex = PendingStateAcks.Num();
+		FCombatRemoteStateAck& Ack = PendingStateAcks.AddDefaulted_GetRef();
+		Ack.NetId = Message.NetId;
+		Ack.PlayerId = PlayerId;
+		Ack.Sequence = Sequence;
+
+		if (bNetIds)
+		{
+			PendingStateAckIndicesByNetId.Add(Message.NetId, NewIndex);
+		}
+		else
+		{
+			PendingStateAckIndicesById.Add(PlayerId, NewIndex);
+		}
+		return;
+	}
+
+	// Never step an acknowledgement back to an older sequence
+	FCombatRemoteStateAck& Ack = PendingStateAcks[*Index];
+	if (CombatNetProtocol::IsSequenceNewer(Sequence, Ack.Sequence))
+	{
+		Ack.Sequence = Sequence;
+	}
+}
+
+void FCombatInboundPipeline::RemoveStateAck(uint32 NetId, const FString& PlayerId)
+{
+	FScopeLock Lock(&StateAckLock);
+
+	int32 Index = INDEX_NONE;
+	const bool bFound = NetId != CombatNetProtocol::InvalidNetId
+		? PendingStateAckIndicesByNetId.RemoveAndCopyValue(NetId, Index)
+		: PendingStateAckIndicesById.RemoveAndCopyValue(PlayerId, Index);
+	if (!bFound)
+	{
+		return;
+	}
+
+	// Keep the index of the entry that moves into the gap
+	PendingStateAcks.RemoveAtSwap(Index, EAllowShrinking::No);
+	if (PendingStateAcks.IsValidIndex(Index))
+	{
+		const FCombatRemoteStateAck& Moved = PendingStateAcks[Index];
+		if (Moved.NetId != CombatNetProtocol::InvalidNetId)
+		{
+			PendingStateAckIndicesByNetId.Add(Moved.NetId, Index);
+		}
+		else
+		{
+			PendingStateAckIndicesById.Add(Moved.PlayerId, Index);
+		}
+	}
+}
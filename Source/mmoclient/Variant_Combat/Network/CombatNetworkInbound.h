@@ -0,0 +1,240 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Pipe.h"
+#include "HAL/CriticalSection.h"
+#include "CombatNetworkMessages.h"
+#include "CombatNetworkProtocol.h"
+#include <atomic>
+
+class FCombatMessageDispatcher;
+
+/**
+ * Intrusive, lock-free multi-producer single-consumer FIFO (Vyukov).
+ * T must expose a std::atomic<T*> QueueNext. Push never allocates; Pop must only be called from one thread.
+ */
+template <typename T>
+class TCombatMpscQueue
+{
+public:
+
+	TCombatMpscQueue()
+		: Head(&Stub)
+		, Tail(&Stub)
+	{
+	}
+
+	/** Appends Node. Safe from any thread */
+	void Push(T* Node)
+	{
+		Node->QueueNext.store(nullptr, std::memory_order_relaxed);
+		T* Previous = Head.exchange(Node, std::memory_order_acq_rel);
+		Previous->QueueNext.store(Node, std::memory_order_release);
+	}
+
+	/** Removes and returns the oldest node, or null if the queue is empty or a push is still being linked in */
+	T* Pop()
+	{
+		T* First = Tail;
+		T* Next = First->QueueNext.load(std::memory_order_acquire);
+
+		if (First == &Stub)
+		{
+			if (!Next)
+			{
+				return nullptr;
+			}
+			Tail = Next;
+			First = Next;
+			Next = Next->QueueNext.load(std::memory_order_acquire);
+		}
+
+		if (Next)
+		{
+			Tail = Next;
+			return First;
+		}
+
+		if (First != Head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		// First is the last node; park the stub behind it so it can be handed out
+		Push(&Stub);
+		Next = First->QueueNext.load(std::memory_order_acquire);
+		if (Next)
+		{
+			Tail = Next;
+			return First;
+		}
+
+		return nullptr;
+	}
+
+private:
+
+	T Stub;
+	std::atomic<T*> Head;
+	T* Tail;
+};
+
+/**
+ * A received WebSocket frame and the message decoded from it.
+ * Frames are pooled, and own the bytes that the decoded message's string views point into.
+ */
+struct FCombatInboundFrame
+{
+	/** Frame contents, UTF-8 text or a binary frame including its header */
+	TArray<uint8> Bytes;
+
+	/** Whether Bytes holds a binary frame */
+	bool bIsBinary = false;
+
+	/** Connection generation the frame was received in. Stale frames are dropped undispatched */
+	uint32 Generation = 0;
+
+	/** Filled in by the decode worker */
+	FCombatInboundMessage Message;
+
+	/** Backing storage for a world_snapshot message, kept across reuse so its arrays don't reallocate */
+	FCombatWorldSnapshot Snapshot;
+
+	/** Backing storage for strings with escape sequences, decoded out of Bytes */
+	TArray<UTF8CHAR> Strings;
+
+	/** Link for TCombatMpscQueue */
+	std::atomic<FCombatInboundFrame*> QueueNext { nullptr };
+};
+
+/**
+ * Moves decoding of inbound frames off the game thread.
+ *
+ * The game thread copies each received frame into a pooled buffer and hands it to a task pipe,
+ * which decodes frames one at a time in arrival order. Decoded frames come back through a
+ * lock-free queue and are dequeued by the game thread at a fixed point in its frame.
+ *
+ * State that decoding depends on (delta baselines, the zone origin and whether players are named
+ * by net id) is owned by the pipe and only changed from tasks on it, so it stays consistent with
+ * the order frames were received in. The deltas it decodes leave acknowledgements behind for the
+ * game thread to collect.
+ */
+class FCombatInboundPipeline
+{
+public:
+
+	explicit FCombatInboundPipeline(const FCombatMessageDispatcher& InDispatcher);
+
+	/** Waits for outstanding decode tasks */
+	~FCombatInboundPipeline();
+
+	/** Game thread. Copies a complete UTF-8 text frame and queues it for decoding */
+	void EnqueueText(const uint8* Data, int32 Size);
+
+	/** Game thread. Copies a complete binary frame and queues it for decoding */
+	void EnqueueBinary(const uint8* Data, int32 Size);
+
+	/** Game thread. Returns the next decoded frame of the current connection in arrival order, or null */
+	FCombatInboundFrame* Dequeue();
+
+	/** Game thread. Returns a dequeued frame to the pool once its message has been handled */
+	void Release(FCombatInboundFrame* Frame);
+
+	/** Game thread. Forgets all decode state; frames received before the reset are dropped */
+	void Reset();
+
+	/**
+	 * Game thread. Drops the delta baselines of a player that left. Players with a net id don't need
+	 * this: the decode worker drops theirs when it decodes their player_joined or player_left, before
+	 * any state of the next player to get the same id
+	 */
+	void ForgetPlayer(const FString& PlayerId);
+
+	/**
+	 * Game thread. Moves out the newest decoded PlayerStateDelta sequence of every player that sent
+	 * one since the last call, replacing OutAcks' contents
+	 */
+	void TakeStateAcks(TArray<FCombatRemoteStateAck>& OutAcks);
+
+	/** Game thread. Blocks until every frame queued so far has been decoded */
+	void WaitForDecode();
+
+	/** Game thread. Bumped by every Reset, so callers can tell a reset happened while they held frames */
+	uint32 GetGeneration() const { return Generation; }
+
+	/** Number of frames received but not yet dequeued */
+	int32 GetNumPending() const { return NumPending; }
+
+private:
+
+	/** Takes a frame from the pool, growing it if needed */
+	FCombatInboundFrame* AcquireFrame();
+
+	/** Copies a frame into a pooled buffer and queues it for decoding on the pipe */
+	void Enqueue(const uint8* Data, int32 Size, bool bIsBinary);
+
+	/** Decode worker. Fills in Frame.Message, leaving its opcode INDEX_NONE on failure */
+	void DecodeFrame(FCombatInboundFrame& Frame);
+	void DecodeTextFrame(FCombatInboundFrame& Frame);
+	void DecodeBinaryFrame(FCombatInboundFrame& Frame);
+	bool DecodePlayerStateDelta(FCombatByteReader& Reader, FCombatPlayerStateMessage& OutMessage);
+
+	/** Decode worker. Reads the player a binary frame is about: a net id if negotiated, a string id otherwise */
+	void ReadPlayer(FCombatByteReader& Reader, FCombatPlayerStateMessage& OutMessage) const;
+
+	/** Decode worker. Delta baselines of the message's player, or null if its net id is out of range */
+	FCombatStateHistory* FindOrAddBaselines(const FCombatPlayerStateMessage& Message);
+
+	/** Decode worker. Drops the delta baselines held for a net id */
+	void ForgetNetId(uint32 NetId);
+
+	/** Decode worker. Records Sequence as the message's player's newest sequence to acknowledge */
+	void AddStateAck(const FCombatPlayerStateMessage& Message, uint16 Sequence);
+
+	/** Decode worker. Drops a left player's acknowledgement that hasn't been collected yet */
+	void RemoveStateAck(uint32 NetId, const FString& PlayerId);
+
+	const FCombatMessageDispatcher& Dispatcher;
+
+	/** Opcodes that binary frames and worker-side state are tied to */
+	int32 JoinResponseOpcode = INDEX_NONE;
+	int32 PlayerJoinedOpcode = INDEX_NONE;
+	int32 PlayerLeftOpcode = INDEX_NONE;
+	int32 PlayerStateOpcode = INDEX_NONE;
+	int32 StateAckOpcode = INDEX_NONE;
+	int32 WorldSnapshotOpcode = INDEX_NONE;
+
+	/** Runs decode tasks one at a time, in the order they were launched */
+	UE::Tasks::FPipe DecodePipe;
+
+	/** Decoded frames on their way back to the game thread */
+	TCombatMpscQueue<FCombatInboundFrame> DecodedFrames;
+
+	/** Every frame ever allocated, and the ones not currently in flight. Game thread only */
+	TArray<TUniquePtr<FCombatInboundFrame>> AllFrames;
+	TArray<FCombatInboundFrame*> FreeFrames;
+
+	/** Bumped by Reset. Game thread only */
+	uint32 Generation = 0;
+
+	/** Frames received but not yet dequeued. Game thread only */
+	int32 NumPending = 0;
+
+	/** Decode worker state: origin that delta positions are quantized against, and whether players are named by net id */
+	FVector ZoneOrigin = FVector::ZeroVector;
+	bool bNetIds = false;
+
+	/** Decode worker state: delta baselines per remote player, indexed by net id, or by string id for servers without net ids */
+	TArray<FCombatStateHistory> NetIdStateBaselines;
+	TMap<FString, FCombatStateHistory> RemoteStateBaselines;
+
+	/** Acknowledgements added by the decode worker and collected by the game thread, one per player, under StateAckLock */
+	FCriticalSection StateAckLock;
+	TArray<FCombatRemoteStateAck> PendingStateAcks;
+
+	/** Index of each player's entry in PendingStateAcks, by net id or by string id. Under StateAckLock */
+	TMap<uint32, int32> PendingStateAckIndicesByNetId;
+	TMap<FString, int32> PendingStateAckIndicesById;
+};
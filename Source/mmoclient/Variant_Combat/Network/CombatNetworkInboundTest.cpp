@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "CombatNetworkDispatch.h"
+#include "CombatNetworkInbound.h"
+#include "CombatNetworkProtocol.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CombatNetInboundTest
+{
+	/** A server PlayerStateDelta frame for a player named by string id, at X = PositionX */
+	TArray<uint8> MakeDelta(const TCHAR* PlayerId, uint16 Sequence, uint8 BaselineAge, int32 PositionX, int32 BaselineX)
+	{
+		FCombatQuantizedState State;
+		State.Position.X = PositionX;
+		FCombatQuantizedState Baseline;
+		Baseline.Position.X = BaselineX;
+
+		TArray<uint8> Frame;
+		FCombatByteWriter Writer(Frame);
+		FCombatNetworkCodec::WriteHeader(Writer, ECombatBinaryOpcode::PlayerStateDelta);
+		Writer.WriteUInt16(Sequence);
+		Writer.WriteString(PlayerId);
+		Writer.WriteUInt8(BaselineAge);
+		FCombatNetworkCodec::WriteStateDelta(Writer, State, BaselineAge > 0 ? Baseline : FCombatQuantizedState());
+		return Frame;
+	}
+
+	/** Sequence acknowledged for PlayerId, or INDEX_NONE */
+	int32 FindAck(const TArray<FCombatRemoteStateAck>& Acks, const TCHAR* PlayerId)
+	{
+		const FCombatRemoteStateAck* Ack = Acks.FindByPredicate([PlayerId](const FCombatRemoteStateAck& Entry) { return Entry.PlayerId == PlayerId; });
+		return Ack ? Ack->Sequence : INDEX_NONE;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatNetInterleavedDeltaAckTest, "Combat.Net.InterleavedDeltaAcks",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCombatNetInterleavedDeltaAckTest::RunTest(const FString& Parameters)
+{
+	using namespace CombatNetInboundTest;
+
+	// Binary deltas only need the opcode they are dispatched under
+	FCombatMessageDispatcher Dispatcher;
+	const int32 PlayerStateOpcode = Dispatcher.RegisterDecodedHandler(UTF8TEXTVIEW("player_state"),
+		[](FUtf8StringView, FCombatInboundMessage&) { return false; }, FCombatInboundMessageHandler());
+
+	FCombatInboundPipeline Pipeline(Dispatcher);
+
+	// Two players, each numbering their deltas in a sequence of their own, interleaved on the wire
+	const TArray<TArray<uint8>> Frames = {
+		MakeDelta(TEXT("a"), 100, 0, 10, 0),
+		MakeDelta(TEXT("b"), 7, 0, 500, 0),
+		MakeDelta(TEXT("a"), 101, 1, 20, 10),
+		MakeDelta(TEXT("b"), 8, 1, 510, 500),
+		MakeDelta(TEXT("a"), 102, 2, 30, 10),
+	};
+	const double ExpectedX[] = { 10.0, 500.0, 20.0, 510.0, 30.0 };
+
+	for (const TArray<uint8>& Frame : Frames)
+	{
+		Pipeline.EnqueueBinary(Frame.GetData(), Frame.Num());
+	}
+	Pipeline.WaitForDecode();
+
+	for (int32 Index = 0; Index < Frames.Num(); ++Index)
+	{
+		FCombatInboundFrame* Frame = Pipeline.Dequeue();
+		if (!TestNotNull(FString::Printf(TEXT("Delta %d decoded"), Index), Frame))
+		{
+			return false;
+		}
+
+		if (TestEqual(FString::Printf(TEXT("Delta %d found its baseline"), Index), Frame->Message.Opcode, PlayerStateOpcode))
+		{
+			TestEqual(FString::Printf(TEXT("Delta %d position"), Index), Frame->Message.Get<FCombatPlayerStateMessage>().State.Position.X, ExpectedX[Index]);
+		}
+		Pipeline.Release(Frame);
+	}
+
+	// One ack per player, each for that player's newest sequence
+	TArray<FCombatRemoteStateAck> Acks;
+	Pipeline.TakeStateAcks(Acks);
+	TestEqual(TEXT("Players acknowledged"), Acks.Num(), 2);
+	TestEqual(TEXT("Player a acknowledged"), FindAck(Acks, TEXT("a")), 102);
+	TestEqual(TEXT("Player b acknowledged"), FindAck(Acks, TEXT("b")), 8);
+
+	// Acks are collected once; the next tick only acknowledges what arrived since
+	const TArray<uint8> Next = MakeDelta(TEXT("b"), 9, 2, 520, 500);
+	Pipeline.EnqueueBinary(Next.GetData(), Next.Num());
+	Pipeline.WaitForDecode();
+	if (FCombatInboundFrame* Frame = Pipeline.Dequeue())
+	{
+		TestEqual(TEXT("Delta against an older acked baseline decoded"), Frame->Message.Opcode, PlayerStateOpcode);
+		Pipeline.Release(Frame);
+	}
+
+	Pipeline.TakeStateAcks(Acks);
+	TestEqual(TEXT("Players acknowledged after the next delta"), Acks.Num(), 1);
+	TestEqual(TEXT("Player b acknowledged after the next delta"), FindAck(Acks, TEXT("b")), 9);
+
+	// The frame the acks go out in: [Count][id][Sequence]
+	TArray<uint8> AckFrame;
+	FCombatNetworkCodec::EncodeRemoteStateAck(AckFrame, Acks, false);
+	FCombatByteReader Reader(AckFrame.GetData(), AckFrame.Num());
+	ECombatBinaryOpcode Opcode;
+	TestTrue(TEXT("Ack frame header"), FCombatNetworkCodec::ReadHeader(Reader, Opcode) && Opcode == ECombatBinaryOpcode::RemoteStateAck);
+	TestEqual(TEXT("Ack frame count"), static_cast<int32>(Reader.ReadUInt16()), 1);
+	TestTrue(TEXT("Ack frame player"), Reader.ReadString() == UTF8TEXTVIEW("b"));
+	TestEqual(TEXT("Ack frame sequence"), static_cast<int32>(Reader.ReadUInt16()), 9);
+	TestTrue(TEXT("Ack frame size"), !Reader.HasError() && Reader.GetRemaining() == 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkInterpolation.h"
+
+namespace
+{
+	/** Weight of each new arrival in the smoothed clock offset */
+	constexpr double ArrivalSmoothing = 0.05;
+}
+
+void FCombatInterpolationBuffer::Configure(double InMaxExtrapolation, double InMaxExtrapolationDistance)
+{
+	MaxExtrapolation = FMath::Max(InMaxExtrapolation, 0.0);
+	MaxExtrapolationDistance = FMath::Max(InMaxExtrapolationDistance, 0.0);
+}
+
+void FCombatInterpolationBuffer::AddState(const FCombatNetworkState& State, double LocalTime)
+{
+	FCombatNetworkState Timed = State;
+	if (Timed.Timestamp <= 0.0)
+	{
+		Timed.Timestamp = LocalTime;
+	}
+
+	if (Num > 0 && Timed.Timestamp <= Get(Num - 1).Timestamp)
+	{
+		// Out of order or duplicate; the newer state already covers this point on the timeline
+		return;
+	}
+
+	const double Offset = LocalTime - Timed.Timestamp;
+	ClockOffset = Num == 0 ? Offset : ClockOffset + (Offset - ClockOffset) * ArrivalSmoothing;
+
+	if (Num == Capacity)
+	{
+		Head = (Head + 1) % Capacity;
+		--Num;
+	}
+
+	States[(Head + Num) % Capacity] = Timed;
+	++Num;
+}
+
+bool FCombatInterpolationBuffer::Sample(double RenderTime, FCombatInterpolatedState& OutState) const
+{
+	if (Num == 0)
+	{
+		return false;
+	}
+
+	OutState.RenderTime = RenderTime;
+	OutState.ExtrapolationTime = 0.0;
+
+	const FCombatNetworkState& Oldest = Get(0);
+	if (RenderTime <= Oldest.Timestamp)
+	{
+		OutState.Position = Oldest.Position;
+		OutState.Velocity = Oldest.Velocity;
+		OutState.Yaw = Oldest.Rotation.Yaw;
+		OutState.bExtrapolated = false;
+		return true;
+	}
+
+	const FCombatNetworkState& Newest = Get(Num - 1);
+	if (RenderTime >= Newest.Timestamp)
+	{
+		// Keep going along the last velocity until the time or distance budget is spent, then hold still
+		const double Ahead = RenderTime - Newest.Timestamp;
+		const double Speed = Newest.Velocity.Size();
+		const double Limit = MaxExtrapolationDistance > 0.0 && Speed > UE_KINDA_SMALL_NUMBER
+			? FMath::Min(MaxExtrapolation, MaxExtrapolationDistance / Speed)
+			: MaxExtrapolation;
+		OutState.Position = Newest.Position + Newest.Velocity * FMath::Min(Ahead, Limit);
+		OutState.Velocity = Ahead <= Limit ? Newest.Velocity : FVector::ZeroVector;
+		OutState.Yaw = Newest.Rotation.Yaw;
+		OutState.bExtrapolated = true;
+		OutState.ExtrapolationTime = Ahead;
+		return true;
+	}
+
+	// Newest pair bracketing the render time. The buffer is short and the render time sits near its end
+	int32 Index = Num - 2;
+	while (Index > 0 && Get(Index).Timestamp > RenderTime)
+	{
+		--Index;
+	}
+
+	const FCombatNetworkState& From = Get(Index);
+	const FCombatNetworkState& To = Get(Index + 1);
+	const double Span = To.Timestamp - From.Timestamp;
+	const double S = (RenderTime - From.Timestamp) / Span;
+	const double S2 = S * S;
+	const double S3 = S2 * S;
+
+	// Cubic Hermite basis and its derivative
+	const double H00 = 2.0 * S3 - 3.0 * S2 + 1.0;
+	const double H10 = S3 - 2.0 * S2 + S;
+	const double H01 = -2.0 * S3 + 3.0 * S2;
+	const double H11 = S3 - S2;
+
+	const double D00 = 6.0 * S2 - 6.0 * S;
+	const double D10 = 3.0 * S2 - 4.0 * S + 1.0;
+	const double D01 = -6.0 * S2 + 6.0 * S;
+	const double D11 = 3.0 * S2 - 2.0 * S;
+
+	OutState.Position = From.Position * H00 + From.Velocity * (H10 * Span) + To.Position * H01 + To.Velocity * (H11 * Span);
+	OutState.Velocity = (From.Position * D00 + To.Position * D01) / Span + From.Velocity * D10 + To.Velocity * D11;
+	OutState.Yaw = From.Rotation.Yaw + FRotator::NormalizeAxis(To.Rotation.Yaw - From.Rotation.Yaw) * S;
+	OutState.bExtrapolated = false;
+	return true;
+}
+
+void FCombatInterpolationBuffer::Reset()
+{
+	Head = 0;
+	Num = 0;
+	ClockOffset = 0.0;
+}
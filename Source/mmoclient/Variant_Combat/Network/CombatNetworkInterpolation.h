@@ -0,0 +1,83 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatNetworkTypes.h"
+
+/**
+ * Movement of a remote player at one point on its timeline
+ */
+struct FCombatInterpolatedState
+{
+	FVector Position = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	double Yaw = 0.0;
+
+	/** Server time the state was sampled at, after the interpolation delay */
+	double RenderTime = 0.0;
+
+	/** Whether the render time was past the newest received state */
+	bool bExtrapolated = false;
+
+	/** How far the render time was past the newest received state, in seconds */
+	double ExtrapolationTime = 0.0;
+};
+
+/**
+ * Timestamped states of one remote player, sampled a little in the past.
+ *
+ * States are rendered at the server time minus an interpolation delay, chosen for the whole
+ * connection by FCombatJitterBuffer, so there is usually a received state on both sides of the
+ * render time. Positions between two states follow
+ * a cubic Hermite curve through both positions and velocities, which keeps curved and
+ * accelerating motion smooth at low send rates. When the render time passes the newest state, the
+ * player keeps moving along its last velocity until either a time or a distance budget is spent,
+ * and then stops. The distance bounds how wrong the guess can get if the player actually stopped
+ * or turned when its states stopped arriving.
+ */
+class FCombatInterpolationBuffer
+{
+public:
+
+	static constexpr int32 Capacity = 32;
+
+	/** Sets how long, in seconds, and how far to extrapolate past the newest state. A distance of 0 doesn't limit it */
+	void Configure(double InMaxExtrapolation, double InMaxExtrapolationDistance = 0.0);
+
+	/**
+	 * Adds a received state. States older than the newest one are dropped.
+	 * States without a server timestamp are placed on the timeline by their arrival time
+	 */
+	void AddState(const FCombatNetworkState& State, double LocalTime);
+
+	/**
+	 * Samples the player at RenderTime on the server timeline, usually the server time minus the interpolation delay.
+	 * @return false if no state has been received yet
+	 */
+	bool Sample(double RenderTime, FCombatInterpolatedState& OutState) const;
+
+	/** Forgets every state, e.g. after a teleport or respawn */
+	void Reset();
+
+	/** Server time corresponding to LocalTime, estimated from the arrival of received states. For when the server clock isn't synchronized */
+	double EstimateServerTime(double LocalTime) const { return LocalTime - ClockOffset; }
+
+	bool IsEmpty() const { return Num == 0; }
+
+private:
+
+	/** Returns the Index-th oldest state */
+	const FCombatNetworkState& Get(int32 Index) const { return States[(Head + Index) % Capacity]; }
+
+	/** States in timestamp order, oldest at Head */
+	FCombatNetworkState States[Capacity];
+	int32 Head = 0;
+	int32 Num = 0;
+
+	/** Smoothed local arrival time minus server timestamp */
+	double ClockOffset = 0.0;
+
+	double MaxExtrapolation = 0.25;
+	double MaxExtrapolationDistance = 0.0;
+};
@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkJitter.h"
+
+namespace
+{
+	/** Weight of each frame in the smoothed spacing, variance and transit time */
+	constexpr double ArrivalSmoothing = 1.0 / 16.0;
+
+	/** Weight of each state in the late ratio. Lower, so a single late state doesn't swing it */
+	constexpr double LateSmoothing = 1.0 / 64.0;
+
+	/** Range of the margin, in standard deviations, and how fast it moves per second */
+	constexpr double MinMargin = 1.0;
+	constexpr double MaxMargin = 4.0;
+	constexpr double MarginGrowRate = 0.5;
+	constexpr double MarginShrinkRate = 0.125;
+
+	/** How fast the delay follows its target, in seconds per second. Growing slows the render timeline down, shrinking speeds it up */
+	constexpr double DelayGrowRate = 0.25;
+	constexpr double DelayShrinkRate = 0.05;
+}
+
+void FCombatJitterBuffer::Configure(double InMinDelay, double InMaxDelay, double InTargetLateRatio)
+{
+	MinDelay = FMath::Max(InMinDelay, 0.0);
+	MaxDelay = FMath::Max(InMaxDelay, MinDelay);
+	TargetLateRatio = FMath::Clamp(InTargetLateRatio, 0.0, 1.0);
+	Delay = FMath::Clamp(Delay, MinDelay, MaxDelay);
+}
+
+void FCombatJitterBuffer::Reset()
+{
+	Delay = MinDelay;
+	Margin = 2.0;
+	InterArrivalMean = 0.0;
+	InterArrivalVariance = 0.0;
+	TransitMean = 0.0;
+	LateRatio = 0.0;
+	bHasArrival = false;
+	bHasTransit = false;
+}
+
+void FCombatJitterBuffer::AddArrival(double Timestamp, double LocalTime, double ArrivalServerTime)
+{
+	if (bHasArrival)
+	{
+		const double Interval = LocalTime - LastArrivalTime;
+
+		// Compare against the spacing the sender intended; without timestamps, against the usual spacing
+		const double Expected = Timestamp > 0.0 && LastTimestamp > 0.0 ? Timestamp - LastTimestamp : InterArrivalMean;
+		const double Deviation = Interval - Expected;
+
+		InterArrivalMean += (Interval - InterArrivalMean) * ArrivalSmoothing;
+		InterArrivalVariance += (Deviation * Deviation - InterArrivalVariance) * ArrivalSmoothing;
+	}
+
+	LastArrivalTime = LocalTime;
+	LastTimestamp = Timestamp;
+	bHasArrival = true;
+
+	if (Timestamp <= 0.0 || ArrivalServerTime <= 0.0)
+	{
+		return;
+	}
+
+	// The state was late if its moment had already been rendered when it arrived
+	const double Transit = ArrivalServerTime - Timestamp;
+	LateRatio += ((Transit > Delay ? 1.0 : 0.0) - LateRatio) * LateSmoothing;
+
+	TransitMean = bHasTransit ? TransitMean + (Transit - TransitMean) * ArrivalSmoothing : Transit;
+	bHasTransit = true;
+}
+
+void FCombatJitterBuffer::Update(double DeltaTime)
+{
+	if (!bHasArrival)
+	{
+		return;
+	}
+
+	// Widen the margin while too many states are late, narrow it while hardly any are
+	if (LateRatio > TargetLateRatio)
+	{
+		Margin = FMath::Min(Margin + MarginGrowRate * DeltaTime, MaxMargin);
+	}
+	else if (LateRatio < TargetLateRatio * 0.5)
+	{
+		Margin = FMath::Max(Margin - MarginShrinkRate * DeltaTime, MinMargin);
+	}
+
+	// Without a synchronized clock, render times are inferred from arrivals and already include the transit time
+	const double Transit = bHasTransit ? FMath::Max(TransitMean, 0.0) : 0.0;
+	const double Target = FMath::Clamp(Transit + Margin * GetInterArrivalDeviation(), MinDelay, MaxDelay);
+
+	if (Target > Delay)
+	{
+		Delay = FMath::Min(Delay + DelayGrowRate * DeltaTime, Target);
+	}
+	else
+	{
+		Delay = FMath::Max(Delay - DelayShrinkRate * DeltaTime, Target);
+	}
+}
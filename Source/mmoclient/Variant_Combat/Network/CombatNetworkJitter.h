@@ -0,0 +1,75 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Chooses how far in the past remote players are rendered, from how states actually arrive.
+ *
+ * Every received state frame updates three statistics of the connection: the mean time between
+ * frames, the variance of that time around the spacing the sender intended (from the frames'
+ * timestamps), and, when the server clock is synchronized, the mean time from a state's timestamp
+ * to its arrival. The ratio of states that arrive after their moment has already been rendered is
+ * tracked as well.
+ *
+ * The target delay is the mean transit time plus a safety margin of K standard deviations. K
+ * itself is steered by the late ratio: it grows while too many states are late and shrinks while
+ * almost none are. The delay follows the target at a bounded rate, faster when growing than when
+ * shrinking, so the render timeline never jumps.
+ */
+class FCombatJitterBuffer
+{
+public:
+
+	/** Sets the delay range, in seconds, and the share of late states to aim for */
+	void Configure(double InMinDelay, double InMaxDelay, double InTargetLateRatio);
+
+	/** Forgets every statistic and returns to the minimum delay */
+	void Reset();
+
+	/**
+	 * Adds a received state frame.
+	 * @param Timestamp server time the state was sampled at, or 0 if unknown
+	 * @param LocalTime local time the frame came off the socket
+	 * @param ArrivalServerTime server time at LocalTime, or 0 if the clock isn't synchronized
+	 */
+	void AddArrival(double Timestamp, double LocalTime, double ArrivalServerTime);
+
+	/** Moves the delay toward its target. Call once per frame */
+	void Update(double DeltaTime);
+
+	/** Current interpolation delay in seconds */
+	double GetDelay() const { return Delay; }
+
+	/** Mean time between state frames, in seconds */
+	double GetInterArrivalMean() const { return InterArrivalMean; }
+
+	/** Standard deviation of the time between frames around the intended spacing, in seconds */
+	double GetInterArrivalDeviation() const { return FMath::Sqrt(InterArrivalVariance); }
+
+	/** Smoothed share of states that arrived after the render time had passed them */
+	double GetLateRatio() const { return LateRatio; }
+
+private:
+
+	double MinDelay = 0.05;
+	double MaxDelay = 0.5;
+	double TargetLateRatio = 0.01;
+
+	double Delay = 0.05;
+
+	/** Standard deviations of margin on top of the mean transit time */
+	double Margin = 2.0;
+
+	double InterArrivalMean = 0.0;
+	double InterArrivalVariance = 0.0;
+	double TransitMean = 0.0;
+	double LateRatio = 0.0;
+
+	/** Previous frame, to measure spacing against */
+	double LastArrivalTime = 0.0;
+	double LastTimestamp = 0.0;
+	bool bHasArrival = false;
+	bool bHasTransit = false;
+};
@@ -0,0 +1,1375 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkJson.h"
+#include "CombatNetworkProtocol.h"
+
+namespace CombatNetJson
+{
+	/** Powers of ten that are exactly representable as doubles */
+	static constexpr double ExactPowersOf10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	static double Pow10(int32 Exponent)
+	{
+		return Exponent < static_cast<int32>(UE_ARRAY_COUNT(ExactPowersOf10)) ? ExactPowersOf10[Exponent] : FMath::Pow(10.0, static_cast<double>(Exponent));
+	}
+
+	static bool IsDigit(UTF8CHAR Char)
+	{
+		return Char >= '0' && Char <= '9';
+	}
+
+	/** Reads the four hex digits of a unicode escape starting at Char */
+	static bool ReadHex4(const UTF8CHAR* Char, const UTF8CHAR* End, uint32& OutValue)
+	{
+		if (End - Char < 4)
+		{
+			return false;
+		}
+
+		OutValue = 0;
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			const UTF8CHAR Digit = Char[Index];
+			uint32 Nibble;
+			if (Digit >= '0' && Digit <= '9') { Nibble = Digit - '0'; }
+			else if (Digit >= 'a' && Digit <= 'f') { Nibble = Digit - 'a' + 10; }
+			else if (Digit >= 'A' && Digit <= 'F') { Nibble = Digit - 'A' + 10; }
+			else { return false; }
+			OutValue = (OutValue << 4) | Nibble;
+		}
+		return true;
+	}
+
+	/** Appends CodePoint as one to four UTF-8 bytes */
+	static void AppendUtf8(TArray<UTF8CHAR>& Out, uint32 CodePoint)
+	{
+		if (CodePoint < 0x80)
+		{
+			Out.Add(static_cast<UTF8CHAR>(CodePoint));
+		}
+		else if (CodePoint < 0x800)
+		{
+			Out.Add(static_cast<UTF8CHAR>(0xC0 | (CodePoint >> 6)));
+			Out.Add(static_cast<UTF8CHAR>(0x80 | (CodePoint & 0x3F)));
+		}
+		else if (CodePoint < 0x10000)
+		{
+			Out.Add(static_cast<UTF8CHAR>(0xE0 | (CodePoint >> 12)));
+			Out.Add(static_cast<UTF8CHAR>(0x80 | ((CodePoint >> 6) & 0x3F)));
+			Out.Add(static_cast<UTF8CHAR>(0x80 | (CodePoint & 0x3F)));
+		}
+		else
+		{
+			Out.Add(static_cast<UTF8CHAR>(0xF0 | (CodePoint >> 18)));
+			Out.Add(static_cast<UTF8CHAR>(0x80 | ((CodePoint >> 12) & 0x3F)));
+			Out.Add(static_cast<UTF8CHAR>(0x80 | ((CodePoint >> 6) & 0x3F)));
+			Out.Add(static_cast<UTF8CHAR>(0x80 | (CodePoint & 0x3F)));
+		}
+	}
+}
+
+bool FCombatJsonReader::BeginObject()
+{
+	return Consume('{');
+}
+
+bool FCombatJsonReader::NextField(FUtf8StringView& OutName)
+{
+	SkipWhitespace();
+	if (bError || Cursor >= End)
+	{
+		return Fail();
+	}
+
+	if (*Cursor == '}')
+	{
+		++Cursor;
+		return false;
+	}
+
+	if (*Cursor == ',')
+	{
+		++Cursor;
+	}
+
+	return ReadString(OutName) && Consume(':');
+}
+
+bool FCombatJsonReader::BeginArray()
+{
+	return Consume('[');
+}
+
+bool FCombatJsonReader::NextElement()
+{
+	SkipWhitespace();
+	if (bError || Cursor >= End)
+	{
+		return Fail();
+	}
+
+	if (*Cursor == ']')
+	{
+		++Cursor;
+		return false;
+	}
+
+	if (*Cursor == ',')
+	{
+		++Cursor;
+	}
+
+	return true;
+}
+
+bool FCombatJsonReader::ReadString(FUtf8StringView& OutValue)
+{
+	const UTF8CHAR* Start;
+	const UTF8CHAR* StringEnd;
+	bool bEscaped;
+	if (!ScanString(Start, StringEnd, bEscaped))
+	{
+		return false;
+	}
+
+	if (bEscaped)
+	{
+		return DecodeEscapedString(Start, StringEnd, OutValue);
+	}
+
+	OutValue = FUtf8StringView(Start, static_cast<int32>(StringEnd - Start));
+	return true;
+}
+
+bool FCombatJsonReader::ScanString(const UTF8CHAR*& OutStart, const UTF8CHAR*& OutEnd, bool& bOutEscaped)
+{
+	if (!Consume('"'))
+	{
+		return false;
+	}
+
+	OutStart = Cursor;
+	bOutEscaped = false;
+	while (Cursor < End && *Cursor != '"')
+	{
+		// Step over the escaped character so an escaped quote doesn't end the string
+		if (*Cursor == '\\')
+		{
+			bOutEscaped = true;
+			Cursor += 2;
+		}
+		else
+		{
+			++Cursor;
+		}
+	}
+
+	if (Cursor >= End)
+	{
+		return Fail();
+	}
+
+	OutEnd = Cursor;
+	++Cursor;
+	return true;
+}
+
+bool FCombatJsonReader::DecodeEscapedString(const UTF8CHAR* Start, const UTF8CHAR* StringEnd, FUtf8StringView& OutValue)
+{
+	// Decoding never lengthens a string, so this much room means the storage won't reallocate
+	// under views already handed out
+	const int32 RawLength = static_cast<int32>(StringEnd - Start);
+	if (!StringStorage || StringStorage->Max() - StringStorage->Num() < RawLength)
+	{
+		return Fail();
+	}
+
+	const int32 Offset = StringStorage->Num();
+	for (const UTF8CHAR* Char = Start; Char < StringEnd; ++Char)
+	{
+		if (*Char != '\\')
+		{
+			StringStorage->Add(*Char);
+			continue;
+		}
+
+		if (++Char >= StringEnd)
+		{
+			return Fail();
+		}
+
+		switch (*Char)
+		{
+			case '"': StringStorage->Add('"'); break;
+			case '\\': StringStorage->Add('\\'); break;
+			case '/': StringStorage->Add('/'); break;
+			case 'b': StringStorage->Add('\b'); break;
+			case 'f': StringStorage->Add('\f'); break;
+			case 'n': StringStorage->Add('\n'); break;
+			case 'r': StringStorage->Add('\r'); break;
+			case 't': StringStorage->Add('\t'); break;
+
+			case 'u':
+			{
+				uint32 CodePoint;
+				if (!CombatNetJson::ReadHex4(Char + 1, StringEnd, CodePoint))
+				{
+					return Fail();
+				}
+				Char += 4;
+
+				// A surrogate pair takes two escapes; an unpaired surrogate becomes U+FFFD, as in FJsonSerializer
+				if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF)
+				{
+					uint32 Low;
+					if (Char + 2 < StringEnd && Char[1] == '\\' && Char[2] == 'u' && CombatNetJson::ReadHex4(Char + 3, StringEnd, Low)
+						&& Low >= 0xDC00 && Low <= 0xDFFF)
+					{
+						CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+						Char += 6;
+					}
+					else
+					{
+						CodePoint = 0xFFFD;
+					}
+				}
+				else if (CodePoint >= 0xDC00 && CodePoint <= 0xDFFF)
+				{
+					CodePoint = 0xFFFD;
+				}
+
+				CombatNetJson::AppendUtf8(*StringStorage, CodePoint);
+				break;
+			}
+
+			default:
+				return Fail();
+		}
+	}
+
+	OutValue = FUtf8StringView(StringStorage->GetData() + Offset, StringStorage->Num() - Offset);
+	return true;
+}
+
+bool FCombatJsonReader::ReadNumber(double& OutValue)
+{
+	OutValue = 0.0;
+
+	SkipWhitespace();
+	if (bError || Cursor >= End)
+	{
+		return Fail();
+	}
+
+	// Treat null as zero, the same way FJsonValue::AsNumber would have
+	if (*Cursor == 'n')
+	{
+		return SkipValue();
+	}
+
+	const bool bNegative = *Cursor == '-';
+	if (bNegative)
+	{
+		++Cursor;
+	}
+
+	// Accumulate up to 19 significant digits into an integer mantissa, then scale once
+	uint64 Mantissa = 0;
+	int32 Exponent = 0;
+	int32 SignificantDigits = 0;
+	bool bHasDigits = false;
+
+	for (; Cursor < End && CombatNetJson::IsDigit(*Cursor); ++Cursor)
+	{
+		bHasDigits = true;
+		if (SignificantDigits < 19)
+		{
+			Mantissa = Mantissa * 10 + (*Cursor - '0');
+			SignificantDigits += Mantissa > 0 ? 1 : 0;
+		}
+		else
+		{
+			++Exponent;
+		}
+	}
+
+	if (Cursor < End && *Cursor == '.')
+	{
+		++Cursor;
+		for (; Cursor < End && CombatNetJson::IsDigit(*Cursor); ++Cursor)
+		{
+			bHasDigits = true;
+			if (SignificantDigits < 19)
+			{
+				Mantissa = Mantissa * 10 + (*Cursor - '0');
+				SignificantDigits += Mantissa > 0 ? 1 : 0;
+				--Exponent;
+			}
+		}
+	}
+
+	if (!bHasDigits)
+	{
+		return Fail();
+	}
+
+	if (Cursor < End && (*Cursor == 'e' || *Cursor == 'E'))
+	{
+		++Cursor;
+
+		bool bNegativeExponent = false;
+		if (Cursor < End && (*Cursor == '-' || *Cursor == '+'))
+		{
+			bNegativeExponent = *Cursor == '-';
+			++Cursor;
+		}
+
+		int32 ExplicitExponent = 0;
+		for (; Cursor < End && CombatNetJson::IsDigit(*Cursor); ++Cursor)
+		{
+			ExplicitExponent = FMath::Min(ExplicitExponent * 10 + (*Cursor - '0'), 1000);
+		}
+		Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+	}
+
+	double Value = static_cast<double>(Mantissa);
+	if (Exponent > 0)
+	{
+		Value *= CombatNetJson::Pow10(Exponent);
+	}
+	else if (Exponent < 0)
+	{
+		// Dividing by an exact power of ten rounds better than multiplying by an inexact reciprocal
+		Value /= CombatNetJson::Pow10(-Exponent);
+	}
+
+	OutValue = bNegative ? -Value : Value;
+	return true;
+}
+
+bool FCombatJsonReader::ReadNumber(float& OutValue)
+{
+	double Value;
+	const bool bResult = ReadNumber(Value);
+	OutValue = static_cast<float>(Value);
+	return bResult;
+}
+
+bool FCombatJsonReader::ReadNumber(int32& OutValue)
+{
+	double Value;
+	const bool bResult = ReadNumber(Value);
+
+	// Converting a double outside the int32 range is undefined, so clamp first
+	OutValue = static_cast<int32>(FMath::Clamp(Value, static_cast<double>(MIN_int32), static_cast<double>(MAX_int32)));
+	return bResult;
+}
+
+bool FCombatJsonReader::ReadBool(bool& bOutValue)
+{
+	bOutValue = false;
+
+	SkipWhitespace();
+	if (bError || Cursor >= End)
+	{
+		return Fail();
+	}
+
+	bOutValue = *Cursor == 't';
+	return SkipValue();
+}
+
+int32 FCombatJsonReader::ReadNumberArray(double* OutValues, int32 MaxCount)
+{
+	if (!BeginArray())
+	{
+		return 0;
+	}
+
+	int32 Count = 0;
+	while (NextElement())
+	{
+		if (Count < MaxCount)
+		{
+			ReadNumber(OutValues[Count]);
+		}
+		else
+		{
+			SkipValue();
+		}
+		++Count;
+	}
+
+	return bError ? 0 : Count;
+}
+
+bool FCombatJsonReader::SkipValue()
+{
+	SkipWhitespace();
+	if (bError || Cursor >= End)
+	{
+		return Fail();
+	}
+
+	// Strings. Skipped ones are only scanned, so their escapes never take up string storage
+	const UTF8CHAR* StringStart;
+	const UTF8CHAR* StringEnd;
+	bool bEscaped;
+	if (*Cursor == '"')
+	{
+		return ScanString(StringStart, StringEnd, bEscaped);
+	}
+
+	// Objects and arrays: track nesting depth, stepping over strings so brackets inside them don't count
+	if (*Cursor == '{' || *Cursor == '[')
+	{
+		int32 Depth = 0;
+		while (Cursor < End)
+		{
+			const UTF8CHAR Char = *Cursor;
+			if (Char == '"')
+			{
+				if (!ScanString(StringStart, StringEnd, bEscaped))
+				{
+					return false;
+				}
+				continue;
+			}
+
+			++Cursor;
+			if (Char == '{' || Char == '[')
+			{
+				++Depth;
+			}
+			else if ((Char == '}' || Char == ']') && --Depth == 0)
+			{
+				return true;
+			}
+		}
+		return Fail();
+	}
+
+	// Numbers and literals run until the next delimiter
+	const UTF8CHAR* Start = Cursor;
+	while (Cursor < End && *Cursor != ',' && *Cursor != '}' && *Cursor != ']' && *Cursor != ' ' && *Cursor != '\t' && *Cursor != '\r' && *Cursor != '\n')
+	{
+		++Cursor;
+	}
+
+	return Cursor > Start ? true : Fail();
+}
+
+bool FCombatJsonReader::ReadRawValue(FUtf8StringView& OutValue)
+{
+	SkipWhitespace();
+
+	const UTF8CHAR* Start = Cursor;
+	if (!SkipValue())
+	{
+		return false;
+	}
+
+	OutValue = FUtf8StringView(Start, static_cast<int32>(Cursor - Start));
+	return true;
+}
+
+bool FCombatJsonReader::Matches(FUtf8StringView Value, const ANSICHAR* Literal)
+{
+	int32 Index = 0;
+	for (; Literal[Index] != '\0'; ++Index)
+	{
+		if (Index >= Value.Len() || Value[Index] != static_cast<UTF8CHAR>(Literal[Index]))
+		{
+			return false;
+		}
+	}
+
+	return Index == Value.Len();
+}
+
+void FCombatJsonReader::SkipWhitespace()
+{
+	while (Cursor < End && (*Cursor == ' ' || *Cursor == '\t' || *Cursor == '\r' || *Cursor == '\n'))
+	{
+		++Cursor;
+	}
+}
+
+bool FCombatJsonReader::Consume(ANSICHAR Expected)
+{
+	SkipWhitespace();
+	if (bError || Cursor >= End || *Cursor != Expected)
+	{
+		return Fail();
+	}
+
+	++Cursor;
+	return true;
+}
+
+bool FCombatJsonReader::Fail()
+{
+	bError = true;
+	return false;
+}
+
+void FCombatJsonWriter::Reset()
+{
+	Buffer.Reset();
+	bNeedsComma = false;
+}
+
+void FCombatJsonWriter::BeginObject()
+{
+	BeforeValue();
+	Buffer.Add('{');
+	bNeedsComma = false;
+}
+
+void FCombatJsonWriter::EndObject()
+{
+	Buffer.Add('}');
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::BeginArray()
+{
+	BeforeValue();
+	Buffer.Add('[');
+	bNeedsComma = false;
+}
+
+void FCombatJsonWriter::EndArray()
+{
+	Buffer.Add(']');
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::Key(const ANSICHAR* Name)
+{
+	BeforeValue();
+	Buffer.Add('"');
+	WriteRaw(Name, FCStringAnsi::Strlen(Name));
+	Buffer.Add('"');
+	Buffer.Add(':');
+	bNeedsComma = false;
+}
+
+void FCombatJsonWriter::Key(FUtf8StringView Name)
+{
+	String(Name);
+	Buffer.Add(':');
+	bNeedsComma = false;
+}
+
+void FCombatJsonWriter::String(FStringView Value)
+{
+	BeforeValue();
+	Buffer.Add('"');
+
+	// Convert runs of characters that need no escaping in one go. Escapes are all ASCII, so a run
+	// never ends inside a surrogate pair
+	auto AppendRun = [this, Value](int32 Start, int32 End)
+	{
+		if (End > Start)
+		{
+			const int32 Length = FPlatformString::ConvertedLength<UTF8CHAR>(Value.GetData() + Start, End - Start);
+			const int32 Offset = Buffer.AddUninitialized(Length);
+			FPlatformString::Convert(reinterpret_cast<UTF8CHAR*>(Buffer.GetData() + Offset), Length, Value.GetData() + Start, End - Start);
+		}
+	};
+
+	int32 RunStart = 0;
+	for (int32 Index = 0; Index < Value.Len(); ++Index)
+	{
+		const TCHAR Char = Value[Index];
+		if (Char == TEXT('"') || Char == TEXT('\\') || static_cast<uint32>(Char) < 0x20)
+		{
+			AppendRun(RunStart, Index);
+			WriteEscape(static_cast<uint32>(Char));
+			RunStart = Index + 1;
+		}
+	}
+	AppendRun(RunStart, Value.Len());
+
+	Buffer.Add('"');
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::String(FUtf8StringView Value)
+{
+	BeforeValue();
+	Buffer.Add('"');
+
+	for (const UTF8CHAR Char : Value)
+	{
+		const uint8 Byte = static_cast<uint8>(Char);
+		if (Byte == '"' || Byte == '\\' || Byte < 0x20)
+		{
+			WriteEscape(Byte);
+		}
+		else
+		{
+			Buffer.Add(Byte);
+		}
+	}
+
+	Buffer.Add('"');
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::Number(double Value)
+{
+	BeforeValue();
+
+	// JSON has no representation for NaN or infinity
+	if (!FMath::IsFinite(Value))
+	{
+		WriteRaw("0", 1);
+	}
+	else
+	{
+		ANSICHAR Text[32];
+		const int32 Length = FCStringAnsi::Snprintf(Text, UE_ARRAY_COUNT(Text), "%.17g", Value);
+		WriteRaw(Text, Length);
+	}
+
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::Number(float Value)
+{
+	BeforeValue();
+
+	if (!FMath::IsFinite(Value))
+	{
+		WriteRaw("0", 1);
+	}
+	else
+	{
+		ANSICHAR Text[32];
+		const int32 Length = FCStringAnsi::Snprintf(Text, UE_ARRAY_COUNT(Text), "%.9g", Value);
+		WriteRaw(Text, Length);
+	}
+
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::Number(int32 Value)
+{
+	BeforeValue();
+
+	ANSICHAR Text[16];
+	const int32 Length = FCStringAnsi::Snprintf(Text, UE_ARRAY_COUNT(Text), "%d", Value);
+	WriteRaw(Text, Length);
+
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::Bool(bool bValue)
+{
+	BeforeValue();
+	if (bValue)
+	{
+		WriteRaw("true", 4);
+	}
+	else
+	{
+		WriteRaw("false", 5);
+	}
+	bNeedsComma = true;
+}
+
+void FCombatJsonWriter::Vector(const FVector& Value)
+{
+	BeginArray();
+	Number(Value.X);
+	Number(Value.Y);
+	Number(Value.Z);
+	EndArray();
+}
+
+void FCombatJsonWriter::BeforeValue()
+{
+	if (bNeedsComma)
+	{
+		Buffer.Add(',');
+	}
+}
+
+void FCombatJsonWriter::WriteEscape(uint32 Char)
+{
+	switch (Char)
+	{
+		case '"':	WriteRaw("\\\"", 2); break;
+		case '\\':	WriteRaw("\\\\", 2); break;
+		case '\n':	WriteRaw("\\n", 2); break;
+		case '\r':	WriteRaw("\\r", 2); break;
+		case '\t':	WriteRaw("\\t", 2); break;
+		default:
+		{
+			ANSICHAR Text[8];
+			const int32 Length = FCStringAnsi::Snprintf(Text, UE_ARRAY_COUNT(Text), "\\u%04x", Char);
+			WriteRaw(Text, Length);
+			break;
+		}
+	}
+}
+
+void FCombatJsonWriter::WriteRaw(const ANSICHAR* Text, int32 Length)
+{
+	const int32 Offset = Buffer.AddUninitialized(Length);
+	FMemory::Memcpy(Buffer.GetData() + Offset, Text, Length);
+}
+
+bool FCombatJsonMessageDecoder::DecodeEnvelope(FUtf8StringView Message, FUtf8StringView& OutType, int32& OutOpcode, FUtf8StringView& OutData)
+{
+	OutType = FUtf8StringView();
+	OutOpcode = INDEX_NONE;
+	OutData = FUtf8StringView();
+
+	FCombatJsonReader Reader(Message);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "type"))
+		{
+			Reader.ReadString(OutType);
+		}
+		else if (FCombatJsonReader::Matches(Name, "op"))
+		{
+			Reader.ReadNumber(OutOpcode);
+		}
+		else if (FCombatJsonReader::Matches(Name, "data"))
+		{
+			Reader.ReadRawValue(OutData);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError() && (!OutType.IsEmpty() || OutOpcode != INDEX_NONE);
+}
+
+namespace
+{
+	/** Reads a net id, leaving OutNetId alone if the value isn't one */
+	void ReadNetId(FCombatJsonReader& Reader, uint32& OutNetId)
+	{
+		int32 NetId = 0;
+		if (Reader.ReadNumber(NetId) && NetId > 0 && static_cast<uint32>(NetId) <= CombatNetProtocol::MaxNetId)
+		{
+			OutNetId = static_cast<uint32>(NetId);
+		}
+	}
+}
+
+bool FCombatJsonMessageDecoder::DecodeJoinResponse(FUtf8StringView Data, FCombatJoinResponseMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "player_id"))
+		{
+			Reader.ReadString(OutMessage.PlayerId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "net_id"))
+		{
+			ReadNetId(Reader, OutMessage.NetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "protocol"))
+		{
+			Reader.ReadString(OutMessage.Protocol);
+		}
+		else if (FCombatJsonReader::Matches(Name, "zone_origin"))
+		{
+			double Values[3] = {};
+			if (Reader.ReadNumberArray(Values, 3) >= 3)
+			{
+				OutMessage.ZoneOrigin = FVector(Values[0], Values[1], Values[2]);
+			}
+		}
+		else if (FCombatJsonReader::Matches(Name, "spawn_position"))
+		{
+			// Server sends X/Y only, Z comes from a ground trace
+			double Values[2] = {};
+			OutMessage.bHasSpawnPosition = Reader.ReadNumberArray(Values, 2) >= 2;
+			OutMessage.SpawnPosition = FVector2D(Values[0], Values[1]);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError();
+}
+
+bool FCombatJsonMessageDecoder::DecodePlayerJoined(FUtf8StringView Data, FCombatPlayerJoinedMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "player_id"))
+		{
+			Reader.ReadString(OutMessage.PlayerId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "net_id"))
+		{
+			ReadNetId(Reader, OutMessage.NetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "position"))
+		{
+			double Values[2] = {};
+			OutMessage.bHasPosition = Reader.ReadNumberArray(Values, 2) >= 2;
+			OutMessage.Position = FVector2D(Values[0], Values[1]);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError();
+}
+
+bool FCombatJsonMessageDecoder::DecodePlayerState(FUtf8StringView Data, FCombatPlayerStateMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FCombatNetworkState& State = OutMessage.State;
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		double Values[3] = {};
+
+		if (FCombatJsonReader::Matches(Name, "player_id"))
+		{
+			Reader.ReadString(OutMessage.PlayerId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "net_id"))
+		{
+			ReadNetId(Reader, OutMessage.NetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "position"))
+		{
+			if (Reader.ReadNumberArray(Values, 3) >= 3)
+			{
+				State.Position = FVector(Values[0], Values[1], Values[2]);
+			}
+		}
+		else if (FCombatJsonReader::Matches(Name, "rotation"))
+		{
+			if (Reader.ReadNumberArray(Values, 3) >= 3)
+			{
+				State.Rotation = FRotator(Values[0], Values[1], Values[2]);
+			}
+		}
+		else if (FCombatJsonReader::Matches(Name, "velocity"))
+		{
+			if (Reader.ReadNumberArray(Values, 3) >= 3)
+			{
+				State.Velocity = FVector(Values[0], Values[1], Values[2]);
+			}
+		}
+		else if (FCombatJsonReader::Matches(Name, "anim_state"))
+		{
+			int32 AnimState = 0;
+			Reader.ReadNumber(AnimState);
+			State.AnimState = CombatNetProtocol::ToAnimationState(AnimState);
+		}
+		else if (FCombatJsonReader::Matches(Name, "combo_stage"))
+		{
+			Reader.ReadNumber(State.ComboStage);
+		}
+		else if (FCombatJsonReader::Matches(Name, "charge_progress"))
+		{
+			Reader.ReadNumber(State.ChargeProgress);
+		}
+		else if (FCombatJsonReader::Matches(Name, "hp"))
+		{
+			Reader.ReadNumber(State.CurrentHP);
+		}
+		else if (FCombatJsonReader::Matches(Name, "max_hp"))
+		{
+			Reader.ReadNumber(State.MaxHP);
+		}
+		else if (FCombatJsonReader::Matches(Name, "timestamp"))
+		{
+			Reader.ReadNumber(State.Timestamp);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError();
+}
+
+bool FCombatJsonMessageDecoder::DecodePlayerLeft(FUtf8StringView Data, FCombatPlayerLeftMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "player_id"))
+		{
+			Reader.ReadString(OutMessage.PlayerId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "net_id"))
+		{
+			ReadNetId(Reader, OutMessage.NetId);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError();
+}
+
+bool FCombatJsonMessageDecoder::DecodePositionCorrection(FUtf8StringView Data, FCombatPositionCorrectionMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "position"))
+		{
+			double Values[3] = {};
+			OutMessage.bHasPosition = Reader.ReadNumberArray(Values, 3) >= 3;
+			OutMessage.Position = FVector(Values[0], Values[1], Values[2]);
+		}
+		else if (FCombatJsonReader::Matches(Name, "velocity"))
+		{
+			double Values[3] = {};
+			OutMessage.bHasVelocity = Reader.ReadNumberArray(Values, 3) >= 3;
+			OutMessage.Velocity = FVector(Values[0], Values[1], Values[2]);
+		}
+		else if (FCombatJsonReader::Matches(Name, "input_seq"))
+		{
+			int32 Sequence;
+			if (Reader.ReadNumber(Sequence))
+			{
+				OutMessage.InputSequence = static_cast<uint16>(Sequence);
+			}
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError();
+}
+
+bool FCombatJsonMessageDecoder::DecodeDamage(FUtf8StringView Data, FCombatDamageMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "attacker_id"))
+		{
+			Reader.ReadString(OutMessage.AttackerId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "target_id"))
+		{
+			Reader.ReadString(OutMessage.TargetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "attacker_net_id"))
+		{
+			ReadNetId(Reader, OutMessage.AttackerNetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "target_net_id"))
+		{
+			ReadNetId(Reader, OutMessage.TargetNetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "damage"))
+		{
+			Reader.ReadNumber(OutMessage.Damage);
+		}
+		else if (FCombatJsonReader::Matches(Name, "target_hp"))
+		{
+			Reader.ReadNumber(OutMessage.TargetHP);
+		}
+		else if (FCombatJsonReader::Matches(Name, "target_dead"))
+		{
+			Reader.ReadBool(OutMessage.bTargetDead);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError();
+}
+
+bool FCombatJsonMessageDecoder::DecodeRespawn(FUtf8StringView Data, FCombatRespawnMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "player_id"))
+		{
+			Reader.ReadString(OutMessage.PlayerId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "net_id"))
+		{
+			ReadNetId(Reader, OutMessage.NetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "hp"))
+		{
+			Reader.ReadNumber(OutMessage.HP);
+		}
+		else if (FCombatJsonReader::Matches(Name, "max_hp"))
+		{
+			Reader.ReadNumber(OutMessage.MaxHP);
+		}
+		else if (FCombatJsonReader::Matches(Name, "position"))
+		{
+			double Values[2] = {};
+			OutMessage.bHasPosition = Reader.ReadNumberArray(Values, 2) >= 2;
+			OutMessage.Position = FVector2D(Values[0], Values[1]);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError();
+}
+
+bool FCombatJsonMessageDecoder::DecodeStateAck(FUtf8StringView Data, FCombatStateAckMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	bool bHasSequence = false;
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "sequence"))
+		{
+			int32 Sequence;
+			bHasSequence = Reader.ReadNumber(Sequence);
+			OutMessage.Sequence = static_cast<uint16>(Sequence);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError() && bHasSequence;
+}
+
+bool FCombatJsonMessageDecoder::DecodePong(FUtf8StringView Data, FCombatPongMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	bool bHasClientTime = false;
+	bool bHasServerTime = false;
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "client_time"))
+		{
+			bHasClientTime = Reader.ReadNumber(OutMessage.ClientTime);
+		}
+		else if (FCombatJsonReader::Matches(Name, "server_time"))
+		{
+			bHasServerTime = Reader.ReadNumber(OutMessage.ServerTime);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	return !Reader.HasError() && bHasClientTime && bHasServerTime;
+}
+
+bool FCombatJsonMessageDecoder::DecodeCombatEvent(FUtf8StringView Data, FCombatEventMessage& OutMessage, TArray<UTF8CHAR>* StringStorage)
+{
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	bool bHasSequence = false;
+	bool bHasEvent = false;
+	int32 Sequence = 0;
+	int32 Event = 0;
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "player_id"))
+		{
+			Reader.ReadString(OutMessage.PlayerId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "net_id"))
+		{
+			ReadNetId(Reader, OutMessage.NetId);
+		}
+		else if (FCombatJsonReader::Matches(Name, "seq"))
+		{
+			bHasSequence = Reader.ReadNumber(Sequence);
+		}
+		else if (FCombatJsonReader::Matches(Name, "event"))
+		{
+			bHasEvent = Reader.ReadNumber(Event);
+		}
+		else if (FCombatJsonReader::Matches(Name, "combo_stage"))
+		{
+			Reader.ReadNumber(OutMessage.ComboStage);
+		}
+		else if (FCombatJsonReader::Matches(Name, "time"))
+		{
+			Reader.ReadNumber(OutMessage.Timestamp);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	// Unknown event types come from newer senders; drop them rather than misplay them
+	if (Reader.HasError() || !bHasSequence || !bHasEvent || (OutMessage.PlayerId.IsEmpty() && OutMessage.NetId == CombatNetProtocol::InvalidNetId)
+		|| Event < 0 || Event > static_cast<int32>(ECombatEventType::Death))
+	{
+		return false;
+	}
+
+	OutMessage.Sequence = static_cast<uint16>(Sequence);
+	OutMessage.Type = static_cast<ECombatEventType>(Event);
+	return true;
+}
+
+namespace
+{
+	/** Appends every number of the next array to OutValues */
+	template <typename ValueType>
+	void ReadNumbers(FCombatJsonReader& Reader, TArray<ValueType>& OutValues)
+	{
+		if (!Reader.BeginArray())
+		{
+			return;
+		}
+
+		while (Reader.NextElement())
+		{
+			if constexpr (std::is_same_v<ValueType, ECombatAnimationState>)
+			{
+				int32 Value;
+				Reader.ReadNumber(Value);
+				OutValues.Add(CombatNetProtocol::ToAnimationState(Value));
+			}
+			else if constexpr (std::is_integral_v<ValueType>)
+			{
+				// Converting a double outside the target range is undefined, so clamp first
+				double Value;
+				Reader.ReadNumber(Value);
+				OutValues.Add(static_cast<ValueType>(FMath::Clamp(Value, static_cast<double>(TNumericLimits<ValueType>::Min()), static_cast<double>(TNumericLimits<ValueType>::Max()))));
+			}
+			else
+			{
+				double Value;
+				Reader.ReadNumber(Value);
+				OutValues.Add(static_cast<ValueType>(Value));
+			}
+		}
+	}
+
+	/** Appends every [x, y, z] triple of the next flat array to OutValues */
+	void ReadVectors(FCombatJsonReader& Reader, TArray<FVector>& OutValues)
+	{
+		if (!Reader.BeginArray())
+		{
+			return;
+		}
+
+		int32 Component = 0;
+		while (Reader.NextElement())
+		{
+			double Value;
+			Reader.ReadNumber(Value);
+			if (Component == 0)
+			{
+				OutValues.AddUninitialized();
+			}
+			OutValues.Last()[Component] = Value;
+			Component = (Component + 1) % 3;
+		}
+
+		// A trailing partial triple means the array doesn't hold whole vectors
+		if (Component != 0)
+		{
+			OutValues.Pop(EAllowShrinking::No);
+		}
+	}
+
+	/** Fills a missing array with zeroes, or reports whether a present one has Count entries */
+	template <typename ValueType>
+	bool MatchCount(TArray<ValueType>& Values, int32 Count)
+	{
+		if (Values.Num() == 0)
+		{
+			Values.SetNumZeroed(Count, EAllowShrinking::No);
+		}
+		return Values.Num() == Count;
+	}
+}
+
+bool FCombatJsonMessageDecoder::DecodeWorldSnapshot(FUtf8StringView Data, FCombatWorldSnapshot& OutSnapshot, TArray<UTF8CHAR>* StringStorage)
+{
+	OutSnapshot.Reset();
+
+	FCombatJsonReader Reader(Data, StringStorage);
+	if (!Reader.BeginObject())
+	{
+		return false;
+	}
+
+	FUtf8StringView Name;
+	while (Reader.NextField(Name))
+	{
+		if (FCombatJsonReader::Matches(Name, "timestamp"))
+		{
+			Reader.ReadNumber(OutSnapshot.Timestamp);
+		}
+		else if (FCombatJsonReader::Matches(Name, "net_ids"))
+		{
+			// Net ids index the remote player slots; one that isn't valid makes the whole snapshot unusable
+			if (Reader.BeginArray())
+			{
+				while (Reader.NextElement())
+				{
+					double NetId;
+					Reader.ReadNumber(NetId);
+					if (NetId < 1.0 || NetId > CombatNetProtocol::MaxNetId)
+					{
+						return false;
+					}
+					OutSnapshot.NetIds.Add(static_cast<uint32>(NetId));
+				}
+			}
+		}
+		else if (FCombatJsonReader::Matches(Name, "ids"))
+		{
+			if (Reader.BeginArray())
+			{
+				while (Reader.NextElement())
+				{
+					Reader.ReadString(OutSnapshot.PlayerIds.AddDefaulted_GetRef());
+				}
+			}
+		}
+		else if (FCombatJsonReader::Matches(Name, "positions"))
+		{
+			ReadVectors(Reader, OutSnapshot.Positions);
+		}
+		else if (FCombatJsonReader::Matches(Name, "velocities"))
+		{
+			ReadVectors(Reader, OutSnapshot.Velocities);
+		}
+		else if (FCombatJsonReader::Matches(Name, "yaws"))
+		{
+			ReadNumbers(Reader, OutSnapshot.Yaws);
+		}
+		else if (FCombatJsonReader::Matches(Name, "anim_states"))
+		{
+			ReadNumbers(Reader, OutSnapshot.AnimStates);
+		}
+		else if (FCombatJsonReader::Matches(Name, "combo_stages"))
+		{
+			ReadNumbers(Reader, OutSnapshot.ComboStages);
+		}
+		else if (FCombatJsonReader::Matches(Name, "hp"))
+		{
+			ReadNumbers(Reader, OutSnapshot.HP);
+		}
+		else if (FCombatJsonReader::Matches(Name, "max_hp"))
+		{
+			ReadNumbers(Reader, OutSnapshot.MaxHP);
+		}
+		else
+		{
+			Reader.SkipValue();
+		}
+	}
+
+	// String ids may come alongside net ids, but then they must name every entry too
+	const int32 Count = OutSnapshot.Num();
+	const bool bConsistent = (OutSnapshot.PlayerIds.Num() == 0 || OutSnapshot.PlayerIds.Num() == Count)
+		&& MatchCount(OutSnapshot.Positions, Count)
+		&& MatchCount(OutSnapshot.Velocities, Count)
+		&& MatchCount(OutSnapshot.Yaws, Count)
+		&& MatchCount(OutSnapshot.AnimStates, Count)
+		&& MatchCount(OutSnapshot.ComboStages, Count)
+		&& MatchCount(OutSnapshot.HP, Count)
+		&& MatchCount(OutSnapshot.MaxHP, Count);
+
+	return !Reader.HasError() && bConsistent;
+}
@@ -0,0 +1,208 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatNetworkMessages.h"
+
+/**
+ * Forward-only JSON tokenizer over a UTF-8 buffer.
+ *
+ * Nothing is allocated: strings come back as views into the source buffer, numbers are parsed in
+ * place and nested values can be skipped or captured as raw spans for a second reader. Strings
+ * that contain escape sequences are decoded into caller-owned storage, see ReadString. The reader is lenient about commas and latches the
+ * first error it sees; once HasError() is true every call returns false or zero.
+ *
+ *	FCombatJsonReader Reader(Text);
+ *	FUtf8StringView Name;
+ *	Reader.BeginObject();
+ *	while (Reader.NextField(Name))
+ *	{
+ *		if (FCombatJsonReader::Matches(Name, "hp")) { Reader.ReadNumber(HP); }
+ *		else { Reader.SkipValue(); }
+ *	}
+ */
+class FCombatJsonReader
+{
+public:
+
+	FCombatJsonReader() = default;
+
+	/**
+	 * @param InStringStorage where strings with escape sequences are decoded to. Its reserved capacity
+	 *	must cover the decoded strings, which a reservation of InText's length always does, so views
+	 *	into it stay valid. Without storage such strings are rejected as malformed
+	 */
+	explicit FCombatJsonReader(FUtf8StringView InText, TArray<UTF8CHAR>* InStringStorage = nullptr)
+		: Cursor(InText.GetData())
+		, End(InText.GetData() + InText.Len())
+		, StringStorage(InStringStorage)
+	{
+	}
+
+	/** Consumes the opening brace of an object */
+	bool BeginObject();
+
+	/**
+	 * Advances to the next field of the current object and reads its name.
+	 * @return false once the closing brace has been consumed, or on error
+	 */
+	bool NextField(FUtf8StringView& OutName);
+
+	/** Consumes the opening bracket of an array */
+	bool BeginArray();
+
+	/**
+	 * Advances to the next element of the current array.
+	 * @return false once the closing bracket has been consumed, or on error
+	 */
+	bool NextElement();
+
+	/**
+	 * Reads a string value. Strings without escape sequences are a view of the text between the
+	 * quotes; others are decoded into the string storage and viewed there
+	 */
+	bool ReadString(FUtf8StringView& OutValue);
+
+	/** Reads a number. A null value reads as zero */
+	bool ReadNumber(double& OutValue);
+	bool ReadNumber(float& OutValue);
+	bool ReadNumber(int32& OutValue);
+
+	/** Reads a true/false literal */
+	bool ReadBool(bool& bOutValue);
+
+	/**
+	 * Reads an array of numbers into OutValues, skipping any beyond MaxCount
+	 * @return the number of elements in the array
+	 */
+	int32 ReadNumberArray(double* OutValues, int32 MaxCount);
+
+	/** Skips over the next value, including any nested objects and arrays */
+	bool SkipValue();
+
+	/** Skips over the next value and returns its raw text, so it can be handed to another reader */
+	bool ReadRawValue(FUtf8StringView& OutValue);
+
+	/** True once any malformed input has been seen */
+	bool HasError() const { return bError; }
+
+	/** Case sensitive comparison of a field name or string value against an ASCII literal */
+	static bool Matches(FUtf8StringView Value, const ANSICHAR* Literal);
+
+private:
+
+	/** Advances past spaces, tabs and line breaks */
+	void SkipWhitespace();
+
+	/** Skips whitespace and consumes Expected, latching an error if it isn't there */
+	bool Consume(ANSICHAR Expected);
+
+	/** Latches the error flag and returns false */
+	bool Fail();
+
+	/** Advances past a string, leaving OutStart and OutEnd around its raw contents. Sets bOutEscaped if it has escape sequences */
+	bool ScanString(const UTF8CHAR*& OutStart, const UTF8CHAR*& OutEnd, bool& bOutEscaped);
+
+	/** Decodes the escape sequences of raw string contents into the string storage */
+	bool DecodeEscapedString(const UTF8CHAR* Start, const UTF8CHAR* StringEnd, FUtf8StringView& OutValue);
+
+	const UTF8CHAR* Cursor = nullptr;
+	const UTF8CHAR* End = nullptr;
+	TArray<UTF8CHAR>* StringStorage = nullptr;
+	bool bError = false;
+};
+
+/**
+ * Appends compact JSON to a caller-owned UTF-8 byte buffer.
+ *
+ * Nothing is allocated beyond growing the buffer, which is never shrunk, so reusing it across
+ * messages settles at zero allocations. Commas are inserted automatically; balancing the
+ * Begin/End calls is up to the caller.
+ *
+ *	FCombatJsonWriter Writer(Buffer);
+ *	Writer.BeginObject();
+ *	Writer.Key("hp");
+ *	Writer.Number(HP);
+ *	Writer.EndObject();
+ */
+class FCombatJsonWriter
+{
+public:
+
+	explicit FCombatJsonWriter(TArray<uint8>& InBuffer)
+		: Buffer(InBuffer)
+	{
+	}
+
+	/** Empties the buffer and starts a new document */
+	void Reset();
+
+	void BeginObject();
+	void EndObject();
+	void BeginArray();
+	void EndArray();
+
+	/** Writes a field name. Literal names are written as-is and must not need escaping */
+	void Key(const ANSICHAR* Name);
+	void Key(FUtf8StringView Name);
+
+	/** Writes an escaped string value, converting to UTF-8 as needed */
+	void String(FStringView Value);
+	void String(FUtf8StringView Value);
+
+	/** Writes a number with enough digits to round-trip its type */
+	void Number(double Value);
+	void Number(float Value);
+	void Number(int32 Value);
+
+	void Bool(bool bValue);
+
+	/** Writes [X, Y, Z] */
+	void Vector(const FVector& Value);
+
+private:
+
+	/** Writes the separating comma if a value precedes this one in the current object or array */
+	void BeforeValue();
+
+	/** Appends the escape sequence for a quote, backslash or control character */
+	void WriteEscape(uint32 Char);
+
+	void WriteRaw(const ANSICHAR* Text, int32 Length);
+
+	TArray<uint8>& Buffer;
+	bool bNeedsComma = false;
+};
+
+/**
+ * Fills the decoded message structs straight from JSON text, without building a DOM.
+ * String fields in the results are views into the source text, or into StringStorage for strings
+ * with escape sequences (see FCombatJsonReader).
+ */
+struct FCombatJsonMessageDecoder
+{
+	/**
+	 * Splits a {"type": ..., "op": ..., "data": ...} envelope into its type, opcode and raw data text.
+	 * Either "type" or "op" must be present; OutOpcode is INDEX_NONE when "op" is absent. Field order doesn't matter
+	 */
+	static bool DecodeEnvelope(FUtf8StringView Message, FUtf8StringView& OutType, int32& OutOpcode, FUtf8StringView& OutData);
+
+	static bool DecodeJoinResponse(FUtf8StringView Data, FCombatJoinResponseMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodePlayerJoined(FUtf8StringView Data, FCombatPlayerJoinedMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodePlayerState(FUtf8StringView Data, FCombatPlayerStateMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodePlayerLeft(FUtf8StringView Data, FCombatPlayerLeftMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodePositionCorrection(FUtf8StringView Data, FCombatPositionCorrectionMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodeDamage(FUtf8StringView Data, FCombatDamageMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodeRespawn(FUtf8StringView Data, FCombatRespawnMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodeStateAck(FUtf8StringView Data, FCombatStateAckMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodePong(FUtf8StringView Data, FCombatPongMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+	static bool DecodeCombatEvent(FUtf8StringView Data, FCombatEventMessage& OutMessage, TArray<UTF8CHAR>* StringStorage = nullptr);
+
+	/**
+	 * Decodes a world_snapshot into OutSnapshot, replacing its contents.
+	 * "ids" sets the entry count; "positions" and "velocities" are flat [x, y, z, ...] arrays, and
+	 * arrays that are missing read as zero for every entry. Fails if a present array has the wrong length.
+	 */
+	static bool DecodeWorldSnapshot(FUtf8StringView Data, FCombatWorldSnapshot& OutSnapshot, TArray<UTF8CHAR>* StringStorage = nullptr);
+};
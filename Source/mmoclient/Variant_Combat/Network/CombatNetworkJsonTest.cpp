@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "CombatNetworkJson.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatNetJsonEscapeTest, "Combat.Net.JsonStringEscapes",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCombatNetJsonEscapeTest::RunTest(const FString& Parameters)
+{
+	// A quote, a backslash, a BMP character and a surrogate pair, next to an unescaped id
+	const FUtf8StringView Data = UTF8TEXTVIEW("{\"player_id\":\"a\\\"b\\\\c\\u00e9\\ud83d\\ude00\",\"position\":[1,2,3],\"name\":\"plain\"}");
+
+	TArray<UTF8CHAR> Strings;
+	Strings.Reserve(Data.Len());
+
+	FCombatPlayerStateMessage Message;
+	TestTrue(TEXT("Decoded with string storage"), FCombatJsonMessageDecoder::DecodePlayerState(Data, Message, &Strings));
+	TestEqual(TEXT("Escapes decoded"), FString(Message.PlayerId), FString(TEXT("a\"b\\c")) + TCHAR(0xE9) + FString(UTF8_TO_TCHAR("\xF0\x9F\x98\x80")));
+	TestEqual(TEXT("Position after the escaped id"), Message.State.Position, FVector(1.0, 2.0, 3.0));
+
+	// The same id must come out the same whichever path it arrives on, so without storage it is rejected, not passed through raw
+	FCombatPlayerStateMessage Rejected;
+	TestFalse(TEXT("Rejected without string storage"), FCombatJsonMessageDecoder::DecodePlayerState(Data, Rejected));
+
+	// The envelope only scans data, leaving its escapes for the message's own decoder
+	FUtf8StringView Type;
+	int32 Opcode;
+	FUtf8StringView Envelope;
+	const FUtf8StringView Frame = UTF8TEXTVIEW("{\"type\":\"player_state\",\"data\":{\"player_id\":\"x\\\\y\"}}");
+	TestTrue(TEXT("Envelope with an escaped string in data"), FCombatJsonMessageDecoder::DecodeEnvelope(Frame, Type, Opcode, Envelope));
+	TestEqual(TEXT("Data span left raw"), FString(Envelope), FString(TEXT("{\"player_id\":\"x\\\\y\"}")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatNetJsonSnapshotValidationTest, "Combat.Net.JsonWorldSnapshotValidation",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCombatNetJsonSnapshotValidationTest::RunTest(const FString& Parameters)
+{
+	FCombatWorldSnapshot Snapshot;
+
+	TestTrue(TEXT("Net ids alone"), FCombatJsonMessageDecoder::DecodeWorldSnapshot(
+		UTF8TEXTVIEW("{\"timestamp\":1,\"net_ids\":[1,2],\"positions\":[0,0,0,1,1,1]}"), Snapshot));
+	TestEqual(TEXT("Net ids alone, entries"), Snapshot.Num(), 2);
+
+	TestTrue(TEXT("Net ids with a string id per entry"), FCombatJsonMessageDecoder::DecodeWorldSnapshot(
+		UTF8TEXTVIEW("{\"net_ids\":[1,2],\"ids\":[\"a\",\"b\"]}"), Snapshot));
+
+	// GetPlayerId indexes the string ids whenever there are any, so they can't be shorter than the net ids
+	TestFalse(TEXT("Fewer string ids than net ids"), FCombatJsonMessageDecoder::DecodeWorldSnapshot(
+		UTF8TEXTVIEW("{\"net_ids\":[1,2,3],\"ids\":[\"a\"]}"), Snapshot));
+
+	TestFalse(TEXT("Negative net id"), FCombatJsonMessageDecoder::DecodeWorldSnapshot(
+		UTF8TEXTVIEW("{\"net_ids\":[1,-4]}"), Snapshot));
+	TestFalse(TEXT("Invalid net id"), FCombatJsonMessageDecoder::DecodeWorldSnapshot(
+		UTF8TEXTVIEW("{\"net_ids\":[0]}"), Snapshot));
+	TestFalse(TEXT("Net id past the largest accepted"), FCombatJsonMessageDecoder::DecodeWorldSnapshot(
+		UTF8TEXTVIEW("{\"net_ids\":[1e12]}"), Snapshot));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,94 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkLagCompensation.h"
+
+void FCombatTransformHistory::Record(double Time, const FVector& Location)
+{
+	if (Num > 0)
+	{
+		const double NewestTime = Get(Num - 1).Time;
+		if (Time <= NewestTime || Time - NewestTime < Window / (Capacity - 1))
+		{
+			return;
+		}
+	}
+
+	// Drop entries that fell out of the window, keeping one older entry to interpolate from
+	while (Num > 1 && Time - Get(1).Time > Window)
+	{
+		Head = (Head + 1) % Capacity;
+		--Num;
+	}
+
+	if (Num == Capacity)
+	{
+		Head = (Head + 1) % Capacity;
+		--Num;
+	}
+
+	FEntry& Entry = Entries[(Head + Num) % Capacity];
+	Entry.Time = Time;
+	Entry.Location = Location;
+	++Num;
+}
+
+bool FCombatTransformHistory::Sample(double Time, FVector& OutLocation) const
+{
+	if (Num == 0 || Time < Get(0).Time || Time > Get(Num - 1).Time)
+	{
+		return false;
+	}
+
+	// Entries are time ordered; find the newest one at or before Time
+	int32 Low = 0;
+	int32 High = Num - 1;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High + 1) / 2;
+		if (Get(Mid).Time <= Time)
+		{
+			Low = Mid;
+		}
+		else
+		{
+			High = Mid - 1;
+		}
+	}
+
+	const FEntry& From = Get(Low);
+	if (Low == Num - 1)
+	{
+		OutLocation = From.Location;
+		return true;
+	}
+
+	const FEntry& To = Get(Low + 1);
+	const double Alpha = (Time - From.Time) / (To.Time - From.Time);
+	OutLocation = FMath::Lerp(From.Location, To.Location, Alpha);
+	return true;
+}
+
+namespace CombatLagCompensation
+{
+	bool SweepHitsCapsule(const FVector& Start, const FVector& End, float SweepRadius,
+		const FVector& CapsuleCenter, float CapsuleHalfHeight, float CapsuleRadius, float Tolerance, FVector& OutHitLocation)
+	{
+		// A capsule is the set of points within its radius of its axis segment
+		const float AxisHalfLength = FMath::Max(CapsuleHalfHeight - CapsuleRadius, 0.0f);
+		const FVector AxisTop = CapsuleCenter + FVector(0.0f, 0.0f, AxisHalfLength);
+		const FVector AxisBottom = CapsuleCenter - FVector(0.0f, 0.0f, AxisHalfLength);
+
+		FVector OnSweep;
+		FVector OnAxis;
+		FMath::SegmentDistToSegmentSafe(Start, End, AxisBottom, AxisTop, OnSweep, OnAxis);
+
+		const FVector AxisToSweep = OnSweep - OnAxis;
+		if (AxisToSweep.SizeSquared() > FMath::Square(SweepRadius + CapsuleRadius + Tolerance))
+		{
+			return false;
+		}
+
+		OutHitLocation = OnAxis + AxisToSweep.GetSafeNormal() * CapsuleRadius;
+		return true;
+	}
+}
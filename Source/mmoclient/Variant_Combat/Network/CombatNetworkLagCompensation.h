@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Where a remote player's networked path had it over the last moments, on the server timeline.
+ *
+ * Remote players are drawn in the past, so a hit landed on one happened at the time it was drawn
+ * at, not at the time the server processes the attack. Keeping its recent positions lets that hit be
+ * checked again against where it actually was then.
+ *
+ * Entries are kept for a fixed window. Frames closer together than the window can resolve in the
+ * fixed capacity are not recorded, so a high frame rate shortens the spacing, never the window.
+ */
+class FCombatTransformHistory
+{
+public:
+
+	static constexpr int32 Capacity = 128;
+
+	/** Sets how far back positions are kept, in seconds */
+	void SetWindow(double InWindow) { Window = FMath::Max(InWindow, 0.0); }
+
+	/** Records Location at Time. Times that aren't newer than the last recorded one are ignored */
+	void Record(double Time, const FVector& Location);
+
+	/**
+	 * Interpolated location at Time.
+	 * @return false if Time is outside the recorded window
+	 */
+	bool Sample(double Time, FVector& OutLocation) const;
+
+	void Reset() { Num = 0; }
+
+private:
+
+	struct FEntry
+	{
+		double Time = 0.0;
+		FVector Location = FVector::ZeroVector;
+	};
+
+	const FEntry& Get(int32 Index) const { return Entries[(Head + Index) % Capacity]; }
+
+	/** Entries in time order, oldest at Head */
+	FEntry Entries[Capacity];
+	int32 Head = 0;
+	int32 Num = 0;
+
+	double Window = 1.0;
+};
+
+namespace CombatLagCompensation
+{
+	/**
+	 * Checks a sphere swept from Start to End against an upright capsule, the shape of a melee trace against a character.
+	 * @param OutHitLocation point on the capsule's surface closest to the sweep, valid when it hits
+	 * @return true if the sweep comes within Tolerance of the capsule
+	 */
+	bool SweepHitsCapsule(const FVector& Start, const FVector& End, float SweepRadius,
+		const FVector& CapsuleCenter, float CapsuleHalfHeight, float CapsuleRadius, float Tolerance, FVector& OutHitLocation);
+}
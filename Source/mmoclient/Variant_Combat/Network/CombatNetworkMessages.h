@@ -0,0 +1,237 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatNetworkTypes.h"
+
+/**
+ * Decoded server -> client messages.
+ *
+ * These are produced by both the JSON and the binary decoders and consumed by the
+ * UCombatNetworkSubsystem handlers. String fields are views into the frame they were decoded
+ * from, so a message must not outlive that frame.
+ *
+ * Players are named by NetId when the server assigns net ids, and by their string id otherwise
+ * (see CombatNetProtocol). A message may carry both; NetId is InvalidNetId when it has none.
+ */
+
+/** TMap key functions for player id views: case sensitive, hashed over the raw bytes */
+template <typename ValueType>
+struct TCombatPlayerIdKeyFuncs : TDefaultMapKeyFuncs<FUtf8StringView, ValueType, false>
+{
+	static bool Matches(FUtf8StringView A, FUtf8StringView B) { return A.Equals(B, ESearchCase::CaseSensitive); }
+	static uint32 GetKeyHash(FUtf8StringView Key) { return FCrc::MemCrc32(Key.GetData(), Key.Len()); }
+};
+
+/** join_response: our player id, the negotiated protocol and where to spawn */
+struct FCombatJoinResponseMessage
+{
+	FUtf8StringView PlayerId;
+
+	/** Our net id, or InvalidNetId if the server doesn't assign them */
+	uint32 NetId = 0;
+
+	FUtf8StringView Protocol;
+	FVector ZoneOrigin = FVector::ZeroVector;
+	FVector2D SpawnPosition = FVector2D::ZeroVector;
+	bool bHasSpawnPosition = false;
+};
+
+/** player_joined: another player entered the zone. Z is found with a ground trace */
+struct FCombatPlayerJoinedMessage
+{
+	FUtf8StringView PlayerId;
+	uint32 NetId = 0;
+	FVector2D Position = FVector2D::ZeroVector;
+	bool bHasPosition = false;
+};
+
+/** player_state: a remote player's sampled state */
+struct FCombatPlayerStateMessage
+{
+	FUtf8StringView PlayerId;
+	uint32 NetId = 0;
+	FCombatNetworkState State;
+};
+
+/** player_left: a remote player left the zone */
+struct FCombatPlayerLeftMessage
+{
+	FUtf8StringView PlayerId;
+	uint32 NetId = 0;
+};
+
+/** position_correction: the server rejected our position */
+struct FCombatPositionCorrectionMessage
+{
+	FVector Position = FVector::ZeroVector;
+	bool bHasPosition = false;
+
+	/** Authoritative velocity, if the server sent one */
+	FVector Velocity = FVector::ZeroVector;
+	bool bHasVelocity = false;
+
+	/** Newest input sequence the server processed to reach Position, or INDEX_NONE */
+	int32 InputSequence = INDEX_NONE;
+};
+
+/** damage: server-authoritative hit result */
+struct FCombatDamageMessage
+{
+	FUtf8StringView AttackerId;
+	FUtf8StringView TargetId;
+	uint32 AttackerNetId = 0;
+	uint32 TargetNetId = 0;
+	float Damage = 0.0f;
+	float TargetHP = 0.0f;
+	bool bTargetDead = false;
+};
+
+/** respawn: a player came back to life. Z is found with a ground trace */
+struct FCombatRespawnMessage
+{
+	FUtf8StringView PlayerId;
+	uint32 NetId = 0;
+	float HP = 0.0f;
+	float MaxHP = 0.0f;
+	FVector2D Position = FVector2D::ZeroVector;
+	bool bHasPosition = false;
+};
+
+/**
+ * world_snapshot: the states of many players sampled at one server time, structure of arrays.
+ * Every array has Num() entries; entry i of each array belongs to NetIds[i], or PlayerIds[i]
+ * if the server doesn't assign net ids. Decoders reject snapshots whose PlayerIds are neither
+ * empty nor Num() long, so PlayerIds can be indexed whenever it isn't empty.
+ * Charge progress and pitch aren't part of snapshots and read as zero.
+ */
+struct FCombatWorldSnapshot
+{
+	/** Server time the states were sampled at */
+	double Timestamp = 0.0;
+
+	TArray<uint32> NetIds;
+	TArray<FUtf8StringView> PlayerIds;
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> Yaws;
+	TArray<ECombatAnimationState> AnimStates;
+	TArray<uint8> ComboStages;
+	TArray<float> HP;
+	TArray<float> MaxHP;
+
+	int32 Num() const { return NetIds.Num() > 0 ? NetIds.Num() : PlayerIds.Num(); }
+
+	/** Net id of entry Index, or InvalidNetId if the snapshot names players by string id */
+	uint32 GetNetId(int32 Index) const { return NetIds.Num() > 0 ? NetIds[Index] : 0; }
+
+	/** String id of entry Index, empty if the snapshot names players by net id */
+	FUtf8StringView GetPlayerId(int32 Index) const { return PlayerIds.Num() > 0 ? PlayerIds[Index] : FUtf8StringView(); }
+
+	/** Empties every array, keeping their allocations for the next snapshot */
+	void Reset()
+	{
+		Timestamp = 0.0;
+		NetIds.Reset();
+		PlayerIds.Reset();
+		Positions.Reset();
+		Velocities.Reset();
+		Yaws.Reset();
+		AnimStates.Reset();
+		ComboStages.Reset();
+		HP.Reset();
+		MaxHP.Reset();
+	}
+
+	/** Expands entry Index into a full state */
+	void GetState(int32 Index, FCombatNetworkState& OutState) const
+	{
+		OutState.Position = Positions[Index];
+		OutState.Rotation = FRotator(0.0f, Yaws[Index], 0.0f);
+		OutState.Velocity = Velocities[Index];
+		OutState.AnimState = AnimStates[Index];
+		OutState.ComboStage = ComboStages[Index];
+		OutState.ChargeProgress = 0.0f;
+		OutState.CurrentHP = HP[Index];
+		OutState.MaxHP = MaxHP[Index];
+		OutState.Timestamp = Timestamp;
+	}
+};
+
+/** state_ack: the newest of our StateDelta sequences the server has applied */
+struct FCombatStateAckMessage
+{
+	uint16 Sequence = 0;
+};
+
+/** combat_event: a discrete combat action of a remote player, relayed in the order it was sent */
+struct FCombatEventMessage
+{
+	FUtf8StringView PlayerId;
+	uint32 NetId = 0;
+	ECombatEventType Type = ECombatEventType::AttackStart;
+	int32 ComboStage = 0;
+	uint16 Sequence = 0;
+	double Timestamp = 0.0;
+};
+
+/** pong: the server's answer to a clock probe */
+struct FCombatPongMessage
+{
+	/** Our local time when the ping was sent, echoed back */
+	double ClientTime = 0.0;
+
+	/** Server time when the server answered */
+	double ServerTime = 0.0;
+};
+
+/**
+ * One decoded inbound message, as handed from the decode worker to the game thread.
+ *
+ * The payload holds exactly one of the message structs above, which one being implied by the
+ * opcode's registered decoder. Only trivially copyable structs fit, so nothing in flight owns
+ * memory and the message can be dropped without cleanup.
+ */
+struct FCombatInboundMessage
+{
+	/** Large enough for the biggest message struct */
+	static constexpr SIZE_T PayloadSize = 160;
+
+	/** Dispatcher opcode of the message type, or INDEX_NONE if the frame failed to decode */
+	int32 Opcode = INDEX_NONE;
+
+	/** Raw JSON "data" text, for handlers that read it themselves. Empty for binary frames */
+	FUtf8StringView Data;
+
+	/** Storage owned by the frame for world_snapshot, which doesn't fit the payload. Reused frame to frame */
+	FCombatWorldSnapshot* Snapshot = nullptr;
+
+	/** Storage owned by the frame for decoded strings that had escape sequences, reserved to the frame's size */
+	TArray<UTF8CHAR>* Strings = nullptr;
+
+	/** Local time (FPlatformTime::Seconds) the frame came off the socket, before any decode or budget delay */
+	double ReceiveTime = 0.0;
+
+	/** Default-constructs a T in the payload and returns it for the decoder to fill */
+	template <typename T>
+	T& Emplace()
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Inbound messages must be POD");
+		static_assert(sizeof(T) <= PayloadSize && alignof(T) <= PayloadAlignment, "Inbound message too large for the payload");
+		return *new (Payload) T();
+	}
+
+	/** The payload as the T its decoder emplaced */
+	template <typename T>
+	const T& Get() const
+	{
+		return *reinterpret_cast<const T*>(Payload);
+	}
+
+private:
+
+	static constexpr SIZE_T PayloadAlignment = 16;
+
+	alignas(PayloadAlignment) uint8 Payload[PayloadSize];
+};
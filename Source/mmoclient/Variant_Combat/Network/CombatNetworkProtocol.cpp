@@ -0,0 +1,394 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkProtocol.h"
+
+FCombatQuantizedState FCombatQuantizedState::Quantize(const FCombatNetworkState& State, const FVector& ZoneOrigin)
+{
+	FCombatQuantizedState Quantized;
+
+	const FVector Local = State.Position - ZoneOrigin;
+	Quantized.Position = FIntVector(FMath::RoundToInt(Local.X), FMath::RoundToInt(Local.Y), FMath::RoundToInt(Local.Z));
+
+	Quantized.Velocity = FIntVector(
+		FMath::Clamp(FMath::RoundToInt(State.Velocity.X), static_cast<int32>(MIN_int16), static_cast<int32>(MAX_int16)),
+		FMath::Clamp(FMath::RoundToInt(State.Velocity.Y), static_cast<int32>(MIN_int16), static_cast<int32>(MAX_int16)),
+		FMath::Clamp(FMath::RoundToInt(State.Velocity.Z), static_cast<int32>(MIN_int16), static_cast<int32>(MAX_int16)));
+
+	Quantized.Pitch = FRotator::CompressAxisToShort(State.Rotation.Pitch);
+	Quantized.Yaw = FRotator::CompressAxisToShort(State.Rotation.Yaw);
+
+	// Never round a living character down to 0%
+	if (State.MaxHP > 0.0f)
+	{
+		const int32 Percent = FMath::RoundToInt(FMath::Clamp(State.CurrentHP / State.MaxHP, 0.0f, 1.0f) * 100.0f);
+		Quantized.HPPercent = static_cast<uint8>(State.CurrentHP > 0.0f ? FMath::Max(Percent, 1) : 0);
+	}
+	Quantized.MaxHP = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(State.MaxHP), 0, static_cast<int32>(MAX_uint16)));
+
+	const uint8 Anim = static_cast<uint8>(State.AnimState) & 0x07;
+	const uint8 Combo = static_cast<uint8>(FMath::Clamp(State.ComboStage, 0, 31));
+	Quantized.AnimCombo = Anim | (Combo << 3);
+
+	Quantized.Charge = static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(State.ChargeProgress, 0.0f, 1.0f) * MAX_uint8));
+
+	Quantized.TimestampMs = static_cast<uint32>(FMath::Max(State.Timestamp, 0.0) * 1000.0);
+
+	return Quantized;
+}
+
+void FCombatQuantizedState::Dequantize(const FVector& ZoneOrigin, FCombatNetworkState& OutState) const
+{
+	OutState.Position = ZoneOrigin + FVector(Position);
+	OutState.Velocity = FVector(Velocity);
+	OutState.Rotation = FRotator(FRotator::DecompressAxisFromShort(Pitch), FRotator::DecompressAxisFromShort(Yaw), 0.0f);
+
+	OutState.MaxHP = MaxHP;
+	OutState.CurrentHP = OutState.MaxHP * HPPercent / 100.0f;
+
+	OutState.AnimState = CombatNetProtocol::ToAnimationState(AnimCombo & 0x07);
+	OutState.ComboStage = AnimCombo >> 3;
+
+	OutState.ChargeProgress = Charge / static_cast<float>(MAX_uint8);
+
+	OutState.Timestamp = TimestampMs / 1000.0;
+}
+
+uint16 FCombatQuantizedState::GetDirtyMask(const FCombatQuantizedState& Baseline) const
+{
+	uint16 Mask = 0;
+
+	Mask |= Position.X != Baseline.Position.X ? ECombatStateDirty::PositionX : 0;
+	Mask |= Position.Y != Baseline.Position.Y ? ECombatStateDirty::PositionY : 0;
+	Mask |= Position.Z != Baseline.Position.Z ? ECombatStateDirty::PositionZ : 0;
+	Mask |= Pitch != Baseline.Pitch ? ECombatStateDirty::Pitch : 0;
+	Mask |= Yaw != Baseline.Yaw ? ECombatStateDirty::Yaw : 0;
+	Mask |= Velocity.X != Baseline.Velocity.X ? ECombatStateDirty::VelocityX : 0;
+	Mask |= Velocity.Y != Baseline.Velocity.Y ? ECombatStateDirty::VelocityY : 0;
+	Mask |= Velocity.Z != Baseline.Velocity.Z ? ECombatStateDirty::VelocityZ : 0;
+	Mask |= HPPercent != Baseline.HPPercent ? ECombatStateDirty::HP : 0;
+	Mask |= MaxHP != Baseline.MaxHP ? ECombatStateDirty::MaxHP : 0;
+	Mask |= AnimCombo != Baseline.AnimCombo ? ECombatStateDirty::AnimCombo : 0;
+	Mask |= Charge != Baseline.Charge ? ECombatStateDirty::Charge : 0;
+
+	return Mask;
+}
+
+void FCombatStateHistory::Store(uint16 Sequence, const FCombatQuantizedState& State)
+{
+	const int32 Index = Sequence % Capacity;
+	States[Index] = State;
+	Sequences[Index] = Sequence;
+	bValid[Index] = true;
+}
+
+const FCombatQuantizedState* FCombatStateHistory::Find(uint16 Sequence) const
+{
+	const int32 Index = Sequence % Capacity;
+	return bValid[Index] && Sequences[Index] == Sequence ? &States[Index] : nullptr;
+}
+
+void FCombatStateHistory::Reset()
+{
+	FMemory::Memzero(bValid, sizeof(bValid));
+}
+
+void FCombatByteWriter::WriteVarUInt32(uint32 Value)
+{
+	while (Value >= 0x80)
+	{
+		WriteUInt8(static_cast<uint8>(Value | 0x80));
+		Value >>= 7;
+	}
+	WriteUInt8(static_cast<uint8>(Value));
+}
+
+void FCombatByteWriter::WriteString(FStringView Value)
+{
+	const FTCHARToUTF8 Converted(Value.GetData(), Value.Len());
+	const int32 Length = FMath::Min(Converted.Length(), static_cast<int32>(MAX_uint8));
+
+	WriteUInt8(static_cast<uint8>(Length));
+	WriteRaw(Converted.Get(), Length);
+}
+
+uint32 FCombatByteReader::ReadVarUInt32()
+{
+	uint32 Value = 0;
+
+	// A uint32 never needs more than 5 groups of 7 bits
+	for (int32 Shift = 0; Shift < 35; Shift += 7)
+	{
+		const uint8 Byte = ReadUInt8();
+		Value |= static_cast<uint32>(Byte & 0x7F) << Shift;
+
+		if ((Byte & 0x80) == 0 || bError)
+		{
+			return Value;
+		}
+	}
+
+	// Over-long encoding
+	bError = true;
+	return 0;
+}
+
+FUtf8StringView FCombatByteReader::ReadString()
+{
+	const int32 Length = ReadUInt8();
+	if (bError || Offset + Length > Size)
+	{
+		bError = true;
+		return FUtf8StringView();
+	}
+
+	const FUtf8StringView Value(reinterpret_cast<const UTF8CHAR*>(Data + Offset), Length);
+	Offset += Length;
+	return Value;
+}
+
+void FCombatNetworkCodec::WriteHeader(FCombatByteWriter& Writer, ECombatBinaryOpcode Opcode)
+{
+	Writer.WriteUInt8(CombatNetProtocol::BinaryMagic);
+	Writer.WriteUInt8(static_cast<uint8>(Opcode));
+}
+
+bool FCombatNetworkCodec::ReadHeader(FCombatByteReader& Reader, ECombatBinaryOpcode& OutOpcode)
+{
+	const uint8 Magic = Reader.ReadUInt8();
+	OutOpcode = static_cast<ECombatBinaryOpcode>(Reader.ReadUInt8());
+
+	return !Reader.HasError() && Magic == CombatNetProtocol::BinaryMagic;
+}
+
+void FCombatNetworkCodec::WriteState(FCombatByteWriter& Writer, const FCombatNetworkState& State)
+{
+	// Position and velocity at full float precision
+	Writer.WriteFloat(State.Position.X);
+	Writer.WriteFloat(State.Position.Y);
+	Writer.WriteFloat(State.Position.Z);
+
+	// Characters never roll, so only pitch and yaw are sent, compressed to 16 bits each
+	Writer.WriteUInt16(FRotator::CompressAxisToShort(State.Rotation.Pitch));
+	Writer.WriteUInt16(FRotator::CompressAxisToShort(State.Rotation.Yaw));
+
+	Writer.WriteFloat(State.Velocity.X);
+	Writer.WriteFloat(State.Velocity.Y);
+	Writer.WriteFloat(State.Velocity.Z);
+
+	// Animation state
+	Writer.WriteUInt8(static_cast<uint8>(State.AnimState));
+	Writer.WriteUInt8(static_cast<uint8>(FMath::Clamp(State.ComboStage, 0, static_cast<int32>(MAX_uint8))));
+	Writer.WriteUInt8(static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(State.ChargeProgress, 0.0f, 1.0f) * MAX_uint8)));
+
+	// Health
+	Writer.WriteFloat(State.CurrentHP);
+	Writer.WriteFloat(State.MaxHP);
+
+	Writer.WriteDouble(State.Timestamp);
+}
+
+void FCombatNetworkCodec::ReadState(FCombatByteReader& Reader, FCombatNetworkState& OutState)
+{
+	OutState.Position.X = Reader.ReadFloat();
+	OutState.Position.Y = Reader.ReadFloat();
+	OutState.Position.Z = Reader.ReadFloat();
+
+	OutState.Rotation.Pitch = FRotator::DecompressAxisFromShort(Reader.ReadUInt16());
+	OutState.Rotation.Yaw = FRotator::DecompressAxisFromShort(Reader.ReadUInt16());
+	OutState.Rotation.Roll = 0.0f;
+
+	OutState.Velocity.X = Reader.ReadFloat();
+	OutState.Velocity.Y = Reader.ReadFloat();
+	OutState.Velocity.Z = Reader.ReadFloat();
+
+	OutState.AnimState = CombatNetProtocol::ToAnimationState(Reader.ReadUInt8());
+	OutState.ComboStage = Reader.ReadUInt8();
+	OutState.ChargeProgress = Reader.ReadUInt8() / static_cast<float>(MAX_uint8);
+
+	OutState.CurrentHP = Reader.ReadFloat();
+	OutState.MaxHP = Reader.ReadFloat();
+
+	OutState.Timestamp = Reader.ReadDouble();
+}
+
+void FCombatNetworkCodec::EncodeStateUpdate(TArray<uint8>& OutFrame, const FCombatNetworkState& State, int32 InputSequence)
+{
+	OutFrame.Reset();
+
+	FCombatByteWriter Writer(OutFrame);
+	WriteHeader(Writer, ECombatBinaryOpcode::StateUpdate);
+	WriteState(Writer, State);
+	WriteInputSequence(Writer, InputSequence);
+}
+
+void FCombatNetworkCodec::WriteInputSequence(FCombatByteWriter& Writer, int32 InputSequence)
+{
+	Writer.WriteUInt8(InputSequence != INDEX_NONE ? 1 : 0);
+	if (InputSequence != INDEX_NONE)
+	{
+		Writer.WriteUInt16(static_cast<uint16>(InputSequence));
+	}
+}
+
+void FCombatNetworkCodec::WriteStateDelta(FCombatByteWriter& Writer, const FCombatQuantizedState& State, const FCombatQuantizedState& Baseline)
+{
+	const uint16 Mask = State.GetDirtyMask(Baseline);
+
+	Writer.WriteUInt16(Mask);
+	Writer.WriteUInt32(State.TimestampMs);
+
+	// Positions move in small steps between snapshots, so their deltas are varints
+	if (Mask & ECombatStateDirty::PositionX) { Writer.WriteVarInt32(State.Position.X - Baseline.Position.X); }
+	if (Mask & ECombatStateDirty::PositionY) { Writer.WriteVarInt32(State.Position.Y - Baseline.Position.Y); }
+	if (Mask & ECombatStateDirty::PositionZ) { Writer.WriteVarInt32(State.Position.Z - Baseline.Position.Z); }
+
+	// Everything else is sent as its new absolute value
+	if (Mask & ECombatStateDirty::Pitch) { Writer.WriteUInt16(State.Pitch); }
+	if (Mask & ECombatStateDirty::Yaw) { Writer.WriteUInt16(State.Yaw); }
+	if (Mask & ECombatStateDirty::VelocityX) { Writer.WriteUInt16(static_cast<uint16>(static_cast<int16>(State.Velocity.X))); }
+	if (Mask & ECombatStateDirty::VelocityY) { Writer.WriteUInt16(static_cast<uint16>(static_cast<int16>(State.Velocity.Y))); }
+	if (Mask & ECombatStateDirty::VelocityZ) { Writer.WriteUInt16(static_cast<uint16>(static_cast<int16>(State.Velocity.Z))); }
+	if (Mask & ECombatStateDirty::HP) { Writer.WriteUInt8(State.HPPercent); }
+	if (Mask & ECombatStateDirty::MaxHP) { Writer.WriteUInt16(State.MaxHP); }
+	if (Mask & ECombatStateDirty::AnimCombo) { Writer.WriteUInt8(State.AnimCombo); }
+	if (Mask & ECombatStateDirty::Charge) { Writer.WriteUInt8(State.Charge); }
+}
+
+void FCombatNetworkCodec::ReadStateDelta(FCombatByteReader& Reader, const FCombatQuantizedState& Baseline, FCombatQuantizedState& OutState)
+{
+	OutState = Baseline;
+
+	const uint16 Mask = Reader.ReadUInt16();
+	OutState.TimestampMs = Reader.ReadUInt32();
+
+	if (Mask & ECombatStateDirty::PositionX) { OutState.Position.X += Reader.ReadVarInt32(); }
+	if (Mask & ECombatStateDirty::PositionY) { OutState.Position.Y += Reader.ReadVarInt32(); }
+	if (Mask & ECombatStateDirty::PositionZ) { OutState.Position.Z += Reader.ReadVarInt32(); }
+
+	if (Mask & ECombatStateDirty::Pitch) { OutState.Pitch = Reader.ReadUInt16(); }
+	if (Mask & ECombatStateDirty::Yaw) { OutState.Yaw = Reader.ReadUInt16(); }
+	if (Mask & ECombatStateDirty::VelocityX) { OutState.Velocity.X = static_cast<int16>(Reader.ReadUInt16()); }
+	if (Mask & ECombatStateDirty::VelocityY) { OutState.Velocity.Y = static_cast<int16>(Reader.ReadUInt16()); }
+	if (Mask & ECombatStateDirty::VelocityZ) { OutState.Velocity.Z = static_cast<int16>(Reader.ReadUInt16()); }
+	if (Mask & ECombatStateDirty::HP) { OutState.HPPercent = Reader.ReadUInt8(); }
+	if (Mask & ECombatStateDirty::MaxHP) { OutState.MaxHP = Reader.ReadUInt16(); }
+	if (Mask & ECombatStateDirty::AnimCombo) { OutState.AnimCombo = Reader.ReadUInt8(); }
+	if (Mask & ECombatStateDirty::Charge) { OutState.Charge = Reader.ReadUInt8(); }
+}
+
+void FCombatNetworkCodec::EncodeRemoteStateAck(TArray<uint8>& OutFrame, TConstArrayView<FCombatRemoteStateAck> Acks, bool bNetIds)
+{
+	OutFrame.Reset();
+
+	FCombatByteWriter Writer(OutFrame);
+	WriteHeader(Writer, ECombatBinaryOpcode::RemoteStateAck);
+
+	const int32 Count = FMath::Min(Acks.Num(), static_cast<int32>(MAX_uint16));
+	Writer.WriteUInt16(static_cast<uint16>(Count));
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		if (bNetIds)
+		{
+			Writer.WriteVarUInt32(Acks[Index].NetId);
+		}
+		else
+		{
+			Writer.WriteString(Acks[Index].PlayerId);
+		}
+		Writer.WriteUInt16(Acks[Index].Sequence);
+	}
+}
+
+void FCombatNetworkCodec::ReadWorldSnapshot(FCombatByteReader& Reader, FCombatWorldSnapshot& OutSnapshot, bool bNetIds)
+{
+	OutSnapshot.Reset();
+	OutSnapshot.Timestamp = Reader.ReadDouble();
+
+	const int32 Count = Reader.ReadUInt16();
+
+	// Every entry takes at least this many bytes; don't size arrays for a count the frame can't hold.
+	// A player id's length byte and the shortest varint net id are both one byte
+	constexpr int32 MinBytesPerEntry = 1 + 12 + 2 + 12 + 1 + 4 + 4;
+	if (Reader.HasError() || Count * MinBytesPerEntry > Reader.GetRemaining())
+	{
+		Reader.SetError();
+		return;
+	}
+
+	if (bNetIds)
+	{
+		OutSnapshot.NetIds.SetNumUninitialized(Count, EAllowShrinking::No);
+	}
+	else
+	{
+		OutSnapshot.PlayerIds.SetNumUninitialized(Count, EAllowShrinking::No);
+	}
+	OutSnapshot.Positions.SetNumUninitialized(Count, EAllowShrinking::No);
+	OutSnapshot.Velocities.SetNumUninitialized(Count, EAllowShrinking::No);
+	OutSnapshot.Yaws.SetNumUninitialized(Count, EAllowShrinking::No);
+	OutSnapshot.AnimStates.SetNumUninitialized(Count, EAllowShrinking::No);
+	OutSnapshot.ComboStages.SetNumUninitialized(Count, EAllowShrinking::No);
+	OutSnapshot.HP.SetNumUninitialized(Count, EAllowShrinking::No);
+	OutSnapshot.MaxHP.SetNumUninitialized(Count, EAllowShrinking::No);
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		if (bNetIds)
+		{
+			OutSnapshot.NetIds[Index] = Reader.ReadVarUInt32();
+			if (OutSnapshot.NetIds[Index] == CombatNetProtocol::InvalidNetId || OutSnapshot.NetIds[Index] > CombatNetProtocol::MaxNetId)
+			{
+				Reader.SetError();
+				return;
+			}
+		}
+		else
+		{
+			OutSnapshot.PlayerIds[Index] = Reader.ReadString();
+		}
+	}
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		FVector& Position = OutSnapshot.Positions[Index];
+		Position.X = Reader.ReadFloat();
+		Position.Y = Reader.ReadFloat();
+		Position.Z = Reader.ReadFloat();
+	}
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		OutSnapshot.Yaws[Index] = FRotator::DecompressAxisFromShort(Reader.ReadUInt16());
+	}
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		FVector& Velocity = OutSnapshot.Velocities[Index];
+		Velocity.X = Reader.ReadFloat();
+		Velocity.Y = Reader.ReadFloat();
+		Velocity.Z = Reader.ReadFloat();
+	}
+
+	// AnimState in the low 3 bits, ComboStage in the high 5 bits, as in FCombatQuantizedState
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const uint8 AnimCombo = Reader.ReadUInt8();
+		OutSnapshot.AnimStates[Index] = CombatNetProtocol::ToAnimationState(AnimCombo & 0x07);
+		OutSnapshot.ComboStages[Index] = AnimCombo >> 3;
+	}
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		OutSnapshot.HP[Index] = Reader.ReadFloat();
+	}
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		OutSnapshot.MaxHP[Index] = Reader.ReadFloat();
+	}
+
+	if (Reader.HasError())
+	{
+		OutSnapshot.Reset();
+	}
+}
@@ -0,0 +1,333 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatNetworkTypes.h"
+#include "CombatNetworkMessages.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "The combat binary wire protocol assumes a little endian host");
+
+/**
+ * Binary wire protocol shared with the game server.
+ *
+ * Every binary WebSocket frame starts with a two byte header, [Magic][Opcode], followed by the
+ * opcode's payload. All multi-byte values are little endian. Strings are a uint8 byte count
+ * followed by that many UTF-8 bytes (no terminator).
+ *
+ * The protocol is negotiated in the join handshake: the client lists the protocols it accepts in
+ * "protocols", and the server picks one and echoes it in join_response "protocol".
+ * Servers that don't answer keep the client on JSON.
+ *
+ * "binary_delta" additionally quantizes states and delta-compresses them against the last
+ * baseline the receiver acknowledged:
+ *  - Position in whole centimetres relative to the zone origin sent in join_response "zone_origin"
+ *  - Pitch/yaw as 16 bit angles, velocity as 16 bit cm/s
+ *  - HP as a 0-100 percentage byte, AnimState and ComboStage packed into one byte
+ *  - A dirty mask flags the fields that differ from the baseline; only those follow
+ * Sequences are 16 bit and wrap. The baseline is referenced by its age relative to the frame's
+ * sequence, with an age of 0 meaning "no baseline, delta against zero".
+ * The server numbers each remote player's deltas in a sequence of their own, so the client
+ * acknowledges them per player, with a RemoteStateAck every network tick that received deltas
+ * whether or not its own state is due.
+ *
+ * Clients that send "net_ids" in the join request accept compact player ids. A server that
+ * assigns them answers with our own "net_id" in join_response, names each remote player's id in
+ * player_joined, and from then on refers to players by "net_id" instead of "player_id". In binary
+ * frames the [player id] string becomes a varint net id. Net ids start at 1 and are reused once
+ * their player has left, so they stay below the zone's peak population.
+ */
+namespace CombatNetProtocol
+{
+	/** First byte of every binary frame. Never a valid first byte of a JSON text frame */
+	inline constexpr uint8 BinaryMagic = 0xCB;
+
+	/** Size of the [Magic][Opcode] frame header */
+	inline constexpr int32 HeaderSize = 2;
+
+	/** Protocol names used in the join handshake */
+	inline constexpr const TCHAR* JsonName = TEXT("json");
+	inline constexpr const TCHAR* BinaryName = TEXT("binary");
+	inline constexpr const TCHAR* BinaryDeltaName = TEXT("binary_delta");
+
+	/** Net id meaning "none": the message names its player by string id only */
+	inline constexpr uint32 InvalidNetId = 0;
+
+	/** Largest net id the client accepts. Remote player state is stored in arrays indexed by net id */
+	inline constexpr uint32 MaxNetId = 0xFFFF;
+
+	/** Converts an anim state off the wire. Values this client doesn't know, e.g. from a newer server, read as Idle */
+	inline ECombatAnimationState ToAnimationState(int32 Value)
+	{
+		return Value >= 0 && Value <= static_cast<int32>(ECombatAnimationState::Dead) ? static_cast<ECombatAnimationState>(Value) : ECombatAnimationState::Idle;
+	}
+
+	/** Returns true if sequence A is more recent than sequence B, accounting for wraparound */
+	inline bool IsSequenceNewer(uint16 A, uint16 B)
+	{
+		return static_cast<int16>(A - B) > 0;
+	}
+}
+
+/**
+ * Opcodes of binary frames
+ */
+enum class ECombatBinaryOpcode : uint8
+{
+	/** Client -> server: the local player's FCombatNetworkState, then [HasInput u8][InputSequence u16, if HasInput] */
+	StateUpdate = 1,
+
+	/** Server -> client: player id (or varint net id, if negotiated) followed by that player's FCombatNetworkState */
+	PlayerState = 2,
+
+	/** Client -> server: [Sequence u16][BaselineAge u8][delta state][HasInput u8][InputSequence u16, if HasInput] */
+	StateDelta = 3,
+
+	/** Server -> client: [Sequence u16, counted per player][player id or varint net id][BaselineAge u8][delta state] */
+	PlayerStateDelta = 4,
+
+	/** Server -> client: [Sequence u16] of the newest StateDelta the server has applied */
+	StateAck = 5,
+
+	/**
+	 * Server -> client: many players' states as structure of arrays,
+	 * [Timestamp f64][Count u16][Count player ids or varint net ids][Count x position 3 x f32][Count x yaw u16]
+	 * [Count x velocity 3 x f32][Count x AnimCombo u8][Count x HP f32][Count x MaxHP f32]
+	 */
+	WorldSnapshot = 6,
+
+	/**
+	 * Client -> server: the newest PlayerStateDelta sequence received of each player that sent one
+	 * since the last ack, [Count u16][Count x ([player id or varint net id][Sequence u16])]
+	 */
+	RemoteStateAck = 7,
+};
+
+/**
+ * Bits of the dirty mask that prefixes a delta-compressed state
+ */
+namespace ECombatStateDirty
+{
+	enum Type : uint16
+	{
+		PositionX	= 1 << 0,
+		PositionY	= 1 << 1,
+		PositionZ	= 1 << 2,
+		Pitch		= 1 << 3,
+		Yaw			= 1 << 4,
+		VelocityX	= 1 << 5,
+		VelocityY	= 1 << 6,
+		VelocityZ	= 1 << 7,
+		HP			= 1 << 8,
+		MaxHP		= 1 << 9,
+		AnimCombo	= 1 << 10,
+		Charge		= 1 << 11,
+	};
+}
+
+/**
+ * FCombatNetworkState reduced to the precision that goes on the wire.
+ * Deltas are computed between quantized states so both ends reconstruct bit-identical baselines.
+ */
+struct FCombatQuantizedState
+{
+	/** Position in cm relative to the zone origin */
+	FIntVector Position = FIntVector::ZeroValue;
+
+	/** Velocity in cm/s, clamped to the int16 range */
+	FIntVector Velocity = FIntVector::ZeroValue;
+
+	/** Compressed rotation axes, see FRotator::CompressAxisToShort */
+	uint16 Pitch = 0;
+	uint16 Yaw = 0;
+
+	/** Current HP as a 0-100 percentage of MaxHP */
+	uint8 HPPercent = 0;
+
+	/** Max HP rounded to a whole number */
+	uint16 MaxHP = 0;
+
+	/** AnimState in the low 3 bits, ComboStage in the high 5 bits */
+	uint8 AnimCombo = 0;
+
+	/** Charge progress mapped to 0-255 */
+	uint8 Charge = 0;
+
+	/** Timestamp in milliseconds. Always sent, never part of the dirty mask */
+	uint32 TimestampMs = 0;
+
+	/** Quantizes a state relative to the zone origin */
+	static FCombatQuantizedState Quantize(const FCombatNetworkState& State, const FVector& ZoneOrigin);
+
+	/** Expands back into a full state relative to the zone origin */
+	void Dequantize(const FVector& ZoneOrigin, FCombatNetworkState& OutState) const;
+
+	/** Returns the ECombatStateDirty bits of every field that differs from Baseline */
+	uint16 GetDirtyMask(const FCombatQuantizedState& Baseline) const;
+};
+
+/**
+ * Fixed size ring of quantized states keyed by sequence number.
+ * Used both for states we sent (awaiting the server's ack) and for baselines received per remote player.
+ */
+struct FCombatStateHistory
+{
+	static constexpr int32 Capacity = 32;
+
+	/** Remembers State as the state for Sequence, evicting whatever was Capacity sequences ago */
+	void Store(uint16 Sequence, const FCombatQuantizedState& State);
+
+	/** Returns the state stored for Sequence, or null if it was never stored or already evicted */
+	const FCombatQuantizedState* Find(uint16 Sequence) const;
+
+	/** Forget all stored states */
+	void Reset();
+
+private:
+
+	FCombatQuantizedState States[Capacity];
+	uint16 Sequences[Capacity] = {};
+	bool bValid[Capacity] = {};
+};
+
+/**
+ * Acknowledgement of the newest delta received from one remote player
+ */
+struct FCombatRemoteStateAck
+{
+	/** The player's net id, or InvalidNetId if the server names players by string id */
+	uint32 NetId = CombatNetProtocol::InvalidNetId;
+	FString PlayerId;
+
+	/** Sequence of the player's newest PlayerStateDelta */
+	uint16 Sequence = 0;
+};
+
+/**
+ * Appends little endian values to a caller-owned buffer.
+ * The buffer is never shrunk, so reusing it across frames doesn't reallocate.
+ */
+struct FCombatByteWriter
+{
+	explicit FCombatByteWriter(TArray<uint8>& InBuffer)
+		: Buffer(InBuffer)
+	{
+	}
+
+	void WriteUInt8(uint8 Value) { Buffer.Add(Value); }
+	void WriteUInt16(uint16 Value) { WriteRaw(&Value, sizeof(Value)); }
+	void WriteUInt32(uint32 Value) { WriteRaw(&Value, sizeof(Value)); }
+	void WriteFloat(float Value) { WriteRaw(&Value, sizeof(Value)); }
+	void WriteDouble(double Value) { WriteRaw(&Value, sizeof(Value)); }
+
+	/** Writes 7 bits per byte, high bit set on all but the last byte */
+	void WriteVarUInt32(uint32 Value);
+
+	/** Zigzag-encodes so small negative values stay small, then writes a varint */
+	void WriteVarInt32(int32 Value) { WriteVarUInt32((static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31)); }
+
+	/** Writes a length-prefixed UTF-8 string, truncated to 255 bytes */
+	void WriteString(FStringView Value);
+
+	void WriteRaw(const void* Data, int32 Size)
+	{
+		const int32 Offset = Buffer.AddUninitialized(Size);
+		FMemory::Memcpy(Buffer.GetData() + Offset, Data, Size);
+	}
+
+	TArray<uint8>& Buffer;
+};
+
+/**
+ * Reads little endian values from a byte view without copying.
+ * Reading past the end latches an error and yields zeroes; check HasError() once at the end.
+ */
+struct FCombatByteReader
+{
+	FCombatByteReader(const uint8* InData, int32 InSize)
+		: Data(InData)
+		, Size(InSize)
+	{
+	}
+
+	uint8 ReadUInt8() { uint8 Value = 0; ReadRaw(&Value, sizeof(Value)); return Value; }
+	uint16 ReadUInt16() { uint16 Value = 0; ReadRaw(&Value, sizeof(Value)); return Value; }
+	uint32 ReadUInt32() { uint32 Value = 0; ReadRaw(&Value, sizeof(Value)); return Value; }
+	float ReadFloat() { float Value = 0.0f; ReadRaw(&Value, sizeof(Value)); return Value; }
+	double ReadDouble() { double Value = 0.0; ReadRaw(&Value, sizeof(Value)); return Value; }
+
+	uint32 ReadVarUInt32();
+	int32 ReadVarInt32() { const uint32 Value = ReadVarUInt32(); return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1); }
+
+	/** Reads a length-prefixed UTF-8 string as a view into the underlying bytes */
+	FUtf8StringView ReadString();
+
+	void ReadRaw(void* Out, int32 Count)
+	{
+		if (bError || Offset + Count > Size)
+		{
+			bError = true;
+			return;
+		}
+		FMemory::Memcpy(Out, Data + Offset, Count);
+		Offset += Count;
+	}
+
+	bool HasError() const { return bError; }
+	int32 GetRemaining() const { return Size - Offset; }
+
+	/** Latches the error flag, for payloads that are well formed byte-wise but inconsistent */
+	void SetError() { bError = true; }
+
+private:
+
+	const uint8* Data = nullptr;
+	int32 Size = 0;
+	int32 Offset = 0;
+	bool bError = false;
+};
+
+/**
+ * Encodes and decodes binary frames
+ */
+struct FCombatNetworkCodec
+{
+	/** Writes the [Magic][Opcode] header */
+	static void WriteHeader(FCombatByteWriter& Writer, ECombatBinaryOpcode Opcode);
+
+	/**
+	 * Reads and validates the frame header
+	 * @return false if the frame is too short or doesn't start with the binary magic byte
+	 */
+	static bool ReadHeader(FCombatByteReader& Reader, ECombatBinaryOpcode& OutOpcode);
+
+	/** Writes a full FCombatNetworkState */
+	static void WriteState(FCombatByteWriter& Writer, const FCombatNetworkState& State);
+
+	/** Reads a full FCombatNetworkState */
+	static void ReadState(FCombatByteReader& Reader, FCombatNetworkState& OutState);
+
+	/** Builds a complete state_update frame into OutFrame, replacing its contents. InputSequence may be INDEX_NONE */
+	static void EncodeStateUpdate(TArray<uint8>& OutFrame, const FCombatNetworkState& State, int32 InputSequence);
+
+	/** Writes [HasInput][InputSequence] for the newest local input command the state includes, or INDEX_NONE */
+	static void WriteInputSequence(FCombatByteWriter& Writer, int32 InputSequence);
+
+	/** Writes [DirtyMask][TimestampMs][dirty fields] for State relative to Baseline */
+	static void WriteStateDelta(FCombatByteWriter& Writer, const FCombatQuantizedState& State, const FCombatQuantizedState& Baseline);
+
+	/** Reads a delta written by WriteStateDelta and applies it on top of Baseline */
+	static void ReadStateDelta(FCombatByteReader& Reader, const FCombatQuantizedState& Baseline, FCombatQuantizedState& OutState);
+
+	/**
+	 * Builds a complete RemoteStateAck frame into OutFrame, replacing its contents.
+	 * @param bNetIds whether players are named by net id rather than string id
+	 */
+	static void EncodeRemoteStateAck(TArray<uint8>& OutFrame, TConstArrayView<FCombatRemoteStateAck> Acks, bool bNetIds);
+
+	/**
+	 * Reads a WorldSnapshot payload into OutSnapshot, replacing its contents. Player ids are views into the reader's bytes.
+	 * @param bNetIds whether players are named by net id rather than string id
+	 */
+	static void ReadWorldSnapshot(FCombatByteReader& Reader, FCombatWorldSnapshot& OutSnapshot, bool bNetIds);
+};
@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkRelevance.h"
+#include "CombatNetworkSettings.h"
+
+void FCombatRelevanceFilter::Configure(const UCombatNetworkSettings& Settings)
+{
+	Radius = Settings.RelevanceRadius;
+	ViewDistance = FMath::Max(Settings.ViewRelevanceDistance, Settings.RelevanceRadius);
+	HysteresisDistance = Settings.RelevanceHysteresisDistance;
+	HysteresisAngle = Settings.RelevanceHysteresisAngle;
+}
+
+void FCombatRelevanceFilter::SetViewer(const FVector& InOrigin, const FVector& ViewLocation, const FRotator& ViewRotation, float FieldOfView)
+{
+	bHasViewer = true;
+	Origin = InOrigin;
+	ViewOrigin = ViewLocation;
+	ViewDirection = ViewRotation.Vector();
+
+	const double HalfAngle = FMath::Clamp(FieldOfView * 0.5, 0.0, 180.0);
+	CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(HalfAngle));
+	CosHalfAngleWithHysteresis = FMath::Cos(FMath::DegreesToRadians(FMath::Min(HalfAngle + HysteresisAngle, 180.0)));
+}
+
+bool FCombatRelevanceFilter::IsRelevant(const FVector& Position, bool bHasPawn) const
+{
+	if (!bHasViewer)
+	{
+		return true;
+	}
+
+	const double Margin = bHasPawn ? HysteresisDistance : 0.0;
+
+	// Close by: relevant whichever way the camera faces, since the player may turn at any moment
+	const double DistanceSq = FVector::DistSquared(Position, Origin);
+	if (DistanceSq <= FMath::Square(Radius + Margin))
+	{
+		return true;
+	}
+
+	if (DistanceSq > FMath::Square(ViewDistance + Margin))
+	{
+		return false;
+	}
+
+	// Further out: only if on screen. A cone as wide as the horizontal field of view covers the frustum
+	const FVector ToPosition = Position - ViewOrigin;
+	const double ToPositionSize = ToPosition.Size();
+	if (ToPositionSize <= UE_KINDA_SMALL_NUMBER)
+	{
+		return true;
+	}
+
+	const double CosAngle = FVector::DotProduct(ToPosition, ViewDirection) / ToPositionSize;
+	return CosAngle >= (bHasPawn ? CosHalfAngleWithHysteresis : CosHalfAngle);
+}
@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCombatNetworkSettings;
+
+/**
+ * Decides which remote players are worth a pawn.
+ *
+ * A player is relevant within a radius of the local player, whichever way the camera faces, or
+ * further out, up to the view distance, inside a cone around the camera's view direction as wide
+ * as its field of view. A player that already has a pawn keeps it until it leaves a larger region:
+ * the radius and view distance grow by the hysteresis distance and the cone by the hysteresis
+ * angle. Players moving along the boundary or a camera turning back and forth therefore don't
+ * spawn and release pawns every frame.
+ */
+class FCombatRelevanceFilter
+{
+public:
+
+	/** Reads the radii and margins from the project settings */
+	void Configure(const UCombatNetworkSettings& Settings);
+
+	/**
+	 * Sets where relevance is measured from this frame.
+	 * @param InOrigin the local player's location
+	 * @param ViewLocation, ViewRotation the camera's point of view
+	 * @param FieldOfView the camera's horizontal field of view, in degrees
+	 */
+	void SetViewer(const FVector& InOrigin, const FVector& ViewLocation, const FRotator& ViewRotation, float FieldOfView);
+
+	/** Makes every player relevant, e.g. while there's no local player to measure from */
+	void ClearViewer() { bHasViewer = false; }
+
+	/**
+	 * Whether a player at Position should have a pawn.
+	 * @param bHasPawn whether it has one now, in which case the hysteresis margins apply
+	 */
+	bool IsRelevant(const FVector& Position, bool bHasPawn) const;
+
+private:
+
+	float Radius = 0.0f;
+	float ViewDistance = 0.0f;
+	float HysteresisDistance = 0.0f;
+	float HysteresisAngle = 0.0f;
+
+	bool bHasViewer = false;
+	FVector Origin = FVector::ZeroVector;
+	FVector ViewOrigin = FVector::ZeroVector;
+	FVector ViewDirection = FVector::ForwardVector;
+
+	/** Cosines of the cone's half angle, without and with the hysteresis angle */
+	double CosHalfAngle = 1.0;
+	double CosHalfAngleWithHysteresis = 1.0;
+};
@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkSendPolicy.h"
+#include "CombatNetworkSettings.h"
+
+void FCombatStateSendPolicy::Configure(const UCombatNetworkSettings& Settings)
+{
+	PositionThreshold = Settings.SendPositionThreshold;
+	YawThreshold = Settings.SendYawThreshold;
+	VelocityThreshold = Settings.SendVelocityThreshold;
+	HeartbeatInterval = Settings.SendHeartbeatInterval;
+}
+
+bool FCombatStateSendPolicy::ShouldSend(const FCombatNetworkState& State, double Now) const
+{
+	if (!bHasSentState || Now - LastSentTime >= HeartbeatInterval)
+	{
+		return true;
+	}
+
+	// Discrete changes can't be extrapolated; remote clients must see every one of them
+	if (State.AnimState != LastSentState.AnimState
+		|| State.ComboStage != LastSentState.ComboStage
+		|| State.CurrentHP != LastSentState.CurrentHP
+		|| State.MaxHP != LastSentState.MaxHP)
+	{
+		return true;
+	}
+
+	if (FVector::DistSquared(State.Position, PredictPosition(Now)) > FMath::Square(PositionThreshold))
+	{
+		return true;
+	}
+
+	if (FVector::DistSquared(State.Velocity, LastSentState.Velocity) > FMath::Square(VelocityThreshold))
+	{
+		return true;
+	}
+
+	return FMath::Abs(FRotator::NormalizeAxis(State.Rotation.Yaw - LastSentState.Rotation.Yaw)) > YawThreshold;
+}
+
+void FCombatStateSendPolicy::NotifySent(const FCombatNetworkState& State, double Now)
+{
+	bHasSentState = true;
+	LastSentState = State;
+	LastSentTime = Now;
+}
+
+void FCombatStateSendPolicy::Reset()
+{
+	bHasSentState = false;
+}
+
+FVector FCombatStateSendPolicy::PredictPosition(double Now) const
+{
+	return LastSentState.Position + LastSentState.Velocity * (Now - LastSentTime);
+}
@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatNetworkTypes.h"
+
+class UCombatNetworkSettings;
+
+/**
+ * Decides when the local player's state is worth sending.
+ *
+ * Remote clients keep moving a player along the velocity of its last state until the next one
+ * arrives. The policy runs the same extrapolation on the last state it let through, and only lets
+ * another one through once the real state has drifted past the configured thresholds, the
+ * animation state or HP changed, or the heartbeat interval ran out. An idle or steadily moving
+ * player therefore costs a heartbeat instead of a state every network tick.
+ */
+class FCombatStateSendPolicy
+{
+public:
+
+	/** Reads the thresholds from the project settings */
+	void Configure(const UCombatNetworkSettings& Settings);
+
+	/** Whether State, sampled at Now, differs enough from what remote clients predict to be sent */
+	bool ShouldSend(const FCombatNetworkState& State, double Now) const;
+
+	/** Records State as the one remote clients now extrapolate from */
+	void NotifySent(const FCombatNetworkState& State, double Now);
+
+	/** Forgets the last sent state, so the next one is always sent */
+	void Reset();
+
+private:
+
+	/** Where remote clients render the last sent state at Now */
+	FVector PredictPosition(double Now) const;
+
+	float PositionThreshold = 0.0f;
+	float YawThreshold = 0.0f;
+	float VelocityThreshold = 0.0f;
+	float HeartbeatInterval = 0.0f;
+
+	bool bHasSentState = false;
+	FCombatNetworkState LastSentState;
+	double LastSentTime = 0.0;
+};
@@ -0,0 +1,9 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatNetworkSettings.h"
+
+UCombatNetworkSettings::UCombatNetworkSettings()
+{
+	CategoryName = TEXT("Game");
+	SectionName = TEXT("Combat Network");
+}
@@ -0,0 +1,158 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "CombatNetworkSettings.generated.h"
+
+/**
+ * Project settings for the combat network client.
+ * Exposed under Project Settings > Game > Combat Network and stored in DefaultGame.ini.
+ */
+UCLASS(Config=Game, DefaultConfig, meta=(DisplayName="Combat Network"))
+class UCombatNetworkSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+
+	UCombatNetworkSettings();
+
+	/** If true, the client offers the binary wire protocol during the join handshake. The server may still answer with JSON */
+	UPROPERTY(Config, EditAnywhere, Category="Protocol")
+	bool bPreferBinaryProtocol = true;
+
+	/** If true, the binary protocol offer includes quantized, delta-compressed state snapshots */
+	UPROPERTY(Config, EditAnywhere, Category="Protocol", meta=(EditCondition="bPreferBinaryProtocol"))
+	bool bUseDeltaCompression = true;
+
+	/**
+	 * If true, the client asks the server for compact numeric player ids in the join handshake, so
+	 * player messages are looked up by index rather than by string. Servers that don't assign them
+	 * keep using string ids
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Protocol")
+	bool bUseNetIds = true;
+
+	/**
+	 * Game thread time per frame, in milliseconds, spent handling messages decoded on the network worker.
+	 * Messages that don't fit wait for the next frame. At least one message is handled every frame
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Performance", meta=(ClampMin="0.1", Units="ms"))
+	float InboundBudgetMs = 2.0f;
+
+	/**
+	 * If true, the network tick only sends the local state when it drifts from what remote clients extrapolate
+	 * from the last one sent, or changes in a way they can't extrapolate. If false, every tick sends
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Send Rate")
+	bool bAdaptiveSendRate = true;
+
+	/** Distance between the actual and the extrapolated position that triggers a send */
+	UPROPERTY(Config, EditAnywhere, Category="Send Rate", meta=(EditCondition="bAdaptiveSendRate", ClampMin="0.0", Units="cm"))
+	float SendPositionThreshold = 10.0f;
+
+	/** Yaw change since the last sent state that triggers a send */
+	UPROPERTY(Config, EditAnywhere, Category="Send Rate", meta=(EditCondition="bAdaptiveSendRate", ClampMin="0.0", Units="deg"))
+	float SendYawThreshold = 5.0f;
+
+	/** Velocity change since the last sent state that triggers a send */
+	UPROPERTY(Config, EditAnywhere, Category="Send Rate", meta=(EditCondition="bAdaptiveSendRate", ClampMin="0.0", Units="cm/s"))
+	float SendVelocityThreshold = 50.0f;
+
+	/** Longest time without a send, so the server and remote clients know the player is still there */
+	UPROPERTY(Config, EditAnywhere, Category="Send Rate", meta=(EditCondition="bAdaptiveSendRate", ClampMin="0.05", Units="s"))
+	float SendHeartbeatInterval = 1.0f;
+
+	/** Time between clock probes once the server clock estimate has settled. A short burst of probes follows every connect */
+	UPROPERTY(Config, EditAnywhere, Category="Clock", meta=(ClampMin="0.25", Units="s"))
+	float ClockProbeInterval = 2.0f;
+
+	/** Shortest time remote players are rendered behind the server, in seconds */
+	UPROPERTY(Config, EditAnywhere, Category="Interpolation", meta=(ClampMin="0.0", Units="s"))
+	float MinInterpolationDelay = 0.05f;
+
+	/** Longest time remote players are rendered behind the server, in seconds */
+	UPROPERTY(Config, EditAnywhere, Category="Interpolation", meta=(ClampMin="0.0", Units="s"))
+	float MaxInterpolationDelay = 0.5f;
+
+	/**
+	 * Share of remote states allowed to arrive after the moment they describe has already been rendered.
+	 * The interpolation delay is kept as low as the connection allows while meeting it
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Interpolation", meta=(ClampMin="0.0", ClampMax="1.0"))
+	float TargetLateStateRatio = 0.01f;
+
+	/** How far back the positions remote players were drawn at are kept, so hits on them can be checked where they were */
+	UPROPERTY(Config, EditAnywhere, Category="Lag Compensation", meta=(ClampMin="0.1", Units="s"))
+	float LagCompensationWindow = 1.0f;
+
+	/**
+	 * If true, a melee hit on a remote player is only sent to the server if the sweep still hits the player
+	 * rewound to the time it was drawn at, which is what the server checks it against
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Lag Compensation")
+	bool bValidateMeleeHits = true;
+
+	/** Slack given to the rewound check, covering quantization and the server's own interpolation */
+	UPROPERTY(Config, EditAnywhere, Category="Lag Compensation", meta=(EditCondition="bValidateMeleeHits", ClampMin="0.0", Units="cm"))
+	float MeleeHitTolerance = 15.0f;
+
+	/** Remote player pawns spawned, hidden, when connecting, so players joining don't each construct one */
+	UPROPERTY(Config, EditAnywhere, Category="Remote Players", meta=(ClampMin="0"))
+	int32 RemotePlayerPoolSize = 32;
+
+	/**
+	 * Time per frame spent spawning remote players, nearest to the local player first. Players waiting
+	 * for their pawn keep receiving states, so they spawn where they are. At least one spawns per frame
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Remote Players", meta=(ClampMin="0.1", Units="ms"))
+	float SpawnBudgetMs = 2.0f;
+
+	/** Most remote player pawns kept for reuse after their players leave. Pawns beyond this are destroyed */
+	UPROPERTY(Config, EditAnywhere, Category="Remote Players", meta=(ClampMin="0"))
+	int32 MaxPooledRemotePlayers = 64;
+
+	/**
+	 * If true, only remote players near the local player or in view get a pawn. The others are kept
+	 * as data, still receiving their states, and get a pawn as soon as they become relevant
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Relevance")
+	bool bUseRelevance = true;
+
+	/** Remote players within this distance of the local player get a pawn whichever way the camera faces */
+	UPROPERTY(Config, EditAnywhere, Category="Relevance", meta=(EditCondition="bUseRelevance", ClampMin="0.0", Units="cm"))
+	float RelevanceRadius = 5000.0f;
+
+	/** Remote players within this distance get a pawn if they are in the camera's field of view */
+	UPROPERTY(Config, EditAnywhere, Category="Relevance", meta=(EditCondition="bUseRelevance", ClampMin="0.0", Units="cm"))
+	float ViewRelevanceDistance = 15000.0f;
+
+	/** How much further than they came in players must go before their pawn is released */
+	UPROPERTY(Config, EditAnywhere, Category="Relevance", meta=(EditCondition="bUseRelevance", ClampMin="0.0", Units="cm"))
+	float RelevanceHysteresisDistance = 1000.0f;
+
+	/** How far outside the field of view players must go before their pawn is released */
+	UPROPERTY(Config, EditAnywhere, Category="Relevance", meta=(EditCondition="bUseRelevance", ClampMin="0.0", ClampMax="90.0", Units="deg"))
+	float RelevanceHysteresisAngle = 15.0f;
+
+	/**
+	 * If true, spawn and respawn heights come from a grid of ground heights, baked with
+	 * Combat.Net.BuildGroundGrid or traced as play needs them, instead of a trace through the whole level each time
+	 */
+	UPROPERTY(Config, EditAnywhere, Category="Ground Grid")
+	bool bUseGroundHeightGrid = true;
+
+	/** Distance between ground grid points. Used for grids built at runtime and by the next bake */
+	UPROPERTY(Config, EditAnywhere, Category="Ground Grid", meta=(EditCondition="bUseGroundHeightGrid", ClampMin="10.0", Units="cm"))
+	float GroundGridCellSize = 200.0f;
+
+	/** Four grid points further apart in height than this straddle a step or a cliff, so the ground between them is traced */
+	UPROPERTY(Config, EditAnywhere, Category="Ground Grid", meta=(EditCondition="bUseGroundHeightGrid", ClampMin="0.0", Units="cm"))
+	float GroundGridMaxHeightSpread = 50.0f;
+
+	/** Ground this far or further below a grid point's top surface makes the point multi-level, so the ground near it is traced */
+	UPROPERTY(Config, EditAnywhere, Category="Ground Grid", meta=(EditCondition="bUseGroundHeightGrid", ClampMin="0.0", Units="cm"))
+	float GroundGridLevelSeparation = 200.0f;
+};
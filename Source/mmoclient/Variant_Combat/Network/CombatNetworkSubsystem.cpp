@@ -2,17 +2,31 @@
 
 #include "CombatNetworkSubsystem.h"
 #include "CombatRemotePlayer.h"
+#include "CombatRemotePlayerPool.h"
+#include "CombatGroundHeightGrid.h"
 #include "CombatCharacter.h"
+#include "CombatNetworkSettings.h"
+#include "CombatPredictedMovementComponent.h"
 #include "WebSocketsModule.h"
-#include "Json.h"
-#include "JsonUtilities.h"
+#include "Misc/CoreDelegates.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Components/CapsuleComponent.h"
 
 DEFINE_LOG_CATEGORY(LogCombatNetwork);
 
+namespace
+{
+	/** Combat events kept for a remote player without a pawn, newest last */
+	constexpr int32 MaxKeptCombatEvents = 16;
+
+	/** Oldest kept combat event replayed when the player gets a pawn, in seconds. Older ones would play out of step with its movement */
+	constexpr double MaxKeptCombatEventAge = 0.5;
+}
+
 void UCombatNetworkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
@@ -20,15 +34,87 @@ void UCombatNetworkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	// Ensure WebSockets module is loaded
 	FModuleManager::Get().LoadModuleChecked(TEXT("WebSockets"));
 
+	RegisterBuiltinMessageHandlers();
+	InboundPipeline = MakeUnique<FCombatInboundPipeline>(MessageDispatcher);
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UCombatNetworkSubsystem::OnWorldPreActorTick);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &UCombatNetworkSubsystem::OnEndFrame);
+
 	UE_LOG(LogCombatNetwork, Log, TEXT("CombatNetworkSubsystem initialized"));
 }
 
 void UCombatNetworkSubsystem::Deinitialize()
 {
 	Disconnect();
+
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	InboundPipeline.Reset();
+
 	Super::Deinitialize();
 }
 
+void UCombatNetworkSubsystem::RegisterBuiltinMessageHandlers()
+{
+	// Most frequent first, so the hottest types get the lowest opcodes
+	WorldSnapshotOpcode = MessageDispatcher.RegisterDecodedHandler(UTF8TEXTVIEW("world_snapshot"),
+		[](FUtf8StringView Data, FCombatInboundMessage& OutMessage)
+		{
+			return FCombatJsonMessageDecoder::DecodeWorldSnapshot(Data, *OutMessage.Snapshot, OutMessage.Strings);
+		},
+		FCombatInboundMessageHandler::CreateWeakLambda(this, [this](const FCombatInboundMessage& Message)
+		{
+			AddStateArrival(Message.Snapshot->Timestamp, Message.ReceiveTime);
+			HandleWorldSnapshot(*Message.Snapshot);
+		}));
+
+	// State handlers also feed the time their frame came off the socket to the jitter buffer
+	PlayerStateOpcode = MessageDispatcher.RegisterDecodedHandler(UTF8TEXTVIEW("player_state"),
+		[](FUtf8StringView Data, FCombatInboundMessage& OutMessage)
+		{
+			return FCombatJsonMessageDecoder::DecodePlayerState(Data, OutMessage.Emplace<FCombatPlayerStateMessage>(), OutMessage.Strings);
+		},
+		FCombatInboundMessageHandler::CreateWeakLambda(this, [this](const FCombatInboundMessage& Message)
+		{
+			const FCombatPlayerStateMessage& PlayerState = Message.Get<FCombatPlayerStateMessage>();
+			AddStateArrival(PlayerState.State.Timestamp, Message.ReceiveTime);
+			HandlePlayerState(PlayerState);
+		}));
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodeStateAck>("state_ack", &UCombatNetworkSubsystem::HandleStateAck);
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodeCombatEvent>("combat_event", &UCombatNetworkSubsystem::HandleCombatEvent);
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodeDamage>("damage", &UCombatNetworkSubsystem::HandleDamage);
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodePositionCorrection>("position_correction", &UCombatNetworkSubsystem::HandlePositionCorrection);
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodeRespawn>("respawn", &UCombatNetworkSubsystem::HandleRespawn);
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodePlayerJoined>("player_joined", &UCombatNetworkSubsystem::HandlePlayerJoined);
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodePlayerLeft>("player_left", &UCombatNetworkSubsystem::HandlePlayerLeft);
+	RegisterBuiltinMessageHandler<&FCombatJsonMessageDecoder::DecodeJoinResponse>("join_response", &UCombatNetworkSubsystem::HandleJoinResponse);
+
+	// The pong handler also needs the time its frame came off the socket
+	MessageDispatcher.RegisterDecodedHandler(UTF8TEXTVIEW("pong"),
+		[](FUtf8StringView Data, FCombatInboundMessage& OutMessage)
+		{
+			return FCombatJsonMessageDecoder::DecodePong(Data, OutMessage.Emplace<FCombatPongMessage>(), OutMessage.Strings);
+		},
+		FCombatInboundMessageHandler::CreateWeakLambda(this, [this](const FCombatInboundMessage& Message)
+		{
+			HandlePong(Message.Get<FCombatPongMessage>(), Message.ReceiveTime);
+		}));
+}
+
+int32 UCombatNetworkSubsystem::RegisterMessageHandler(FUtf8StringView Type, FCombatNetworkMessageHandler Handler)
+{
+	const int32 Opcode = MessageDispatcher.RegisterHandler(Type, MoveTemp(Handler));
+	if (Opcode == INDEX_NONE)
+	{
+		UE_LOG(LogCombatNetwork, Warning, TEXT("Message type %s already has a handler"), *FString(Type));
+	}
+	return Opcode;
+}
+
+void UCombatNetworkSubsystem::UnregisterMessageHandler(int32 Opcode)
+{
+	MessageDispatcher.UnregisterHandler(Opcode);
+}
+
 void UCombatNetworkSubsystem::Connect(const FString& URL)
 {
 	if (WebSocket.IsValid() && WebSocket->IsConnected())
@@ -39,6 +125,19 @@ void UCombatNetworkSubsystem::Connect(const FString& URL)
 
 	UE_LOG(LogCombatNetwork, Log, TEXT("Connecting to %s"), *URL);
 
+	const UCombatNetworkSettings* Settings = GetDefault<UCombatNetworkSettings>();
+	NetworkStats = FCombatNetworkStats();
+	StateSendPolicy.Configure(*Settings);
+	ClockSync.SetProbeInterval(Settings->ClockProbeInterval);
+	JitterBuffer.Configure(Settings->MinInterpolationDelay, Settings->MaxInterpolationDelay, Settings->TargetLateStateRatio);
+	RelevanceFilter.Configure(*Settings);
+
+	// Construct remote player pawns now rather than in the middle of play when players join
+	if (UCombatRemotePlayerPool* Pool = GetRemotePlayerPool())
+	{
+		Pool->Prewarm(RemotePlayerClass, Settings->RemotePlayerPoolSize);
+	}
+
 	// Create WebSocket connection
 	WebSocket = FWebSocketsModule::Get().CreateWebSocket(URL);
 
@@ -46,7 +145,8 @@ void UCombatNetworkSubsystem::Connect(const FString& URL)
 	WebSocket->OnConnected().AddUObject(this, &UCombatNetworkSubsystem::OnConnected);
 	WebSocket->OnConnectionError().AddUObject(this, &UCombatNetworkSubsystem::OnConnectionError);
 	WebSocket->OnClosed().AddUObject(this, &UCombatNetworkSubsystem::OnClosed);
-	WebSocket->OnMessage().AddUObject(this, &UCombatNetworkSubsystem::OnMessage);
+	WebSocket->OnRawMessage().AddUObject(this, &UCombatNetworkSubsystem::OnRawMessage);
+	WebSocket->OnBinaryMessage().AddUObject(this, &UCombatNetworkSubsystem::OnBinaryMessage);
 
 	// Connect
 	WebSocket->Connect();
@@ -60,26 +160,20 @@ void UCombatNetworkSubsystem::Disconnect()
 	{
 		if (WebSocket->IsConnected())
 		{
-			// Send leave message
-			TSharedPtr<FJsonObject> EmptyData = MakeShareable(new FJsonObject());
-			SendMessage(TEXT("leave"), EmptyData);
+			// Send leave message. It goes out together with anything else queued this frame, before the socket closes
+			BeginMessage("leave");
+			QueueMessage(true);
 
 			WebSocket->Close();
 		}
 		WebSocket.Reset();
 	}
 
-	// Destroy all remote players
-	for (auto& Pair : RemotePlayers)
-	{
-		if (Pair.Value)
-		{
-			Pair.Value->Destroy();
-		}
-	}
-	RemotePlayers.Empty();
+	// Keep the pawns for when players show up again
+	ReleaseAllRemotePlayers();
 
 	bIsConnected = false;
+	ResetProtocolState();
 	LocalPlayerId.Empty();
 }
 
@@ -95,37 +189,75 @@ void UCombatNetworkSubsystem::SendPlayerState(const FCombatNetworkState& State)
 		return;
 	}
 
-	TSharedPtr<FJsonObject> Data = MakeShareable(new FJsonObject());
+	// Remote clients extrapolate from this state until the next one
+	StateSendPolicy.NotifySent(State, FPlatformTime::Seconds());
+	++NetworkStats.StatesSent;
+
+	// A state already sent this frame includes whatever action asked for one
+	bStateSendRequested = false;
 
-	// Position as array
-	TArray<TSharedPtr<FJsonValue>> PosArray;
-	PosArray.Add(MakeShareable(new FJsonValueNumber(State.Position.X)));
-	PosArray.Add(MakeShareable(new FJsonValueNumber(State.Position.Y)));
-	PosArray.Add(MakeShareable(new FJsonValueNumber(State.Position.Z)));
-	Data->SetArrayField(TEXT("position"), PosArray);
+	// Put the state on the server's timeline once we know it, so it interpolates against everyone else's
+	FCombatNetworkState StampedState = State;
+	if (ClockSync.IsSynchronized())
+	{
+		StampedState.Timestamp = GetServerTime();
+	}
 
-	// Rotation as array
-	TArray<TSharedPtr<FJsonValue>> RotArray;
-	RotArray.Add(MakeShareable(new FJsonValueNumber(State.Rotation.Pitch)));
-	RotArray.Add(MakeShareable(new FJsonValueNumber(State.Rotation.Yaw)));
-	RotArray.Add(MakeShareable(new FJsonValueNumber(State.Rotation.Roll)));
-	Data->SetArrayField(TEXT("rotation"), RotArray);
+	// The newest predicted input the state includes, for the server to echo when it corrects us
+	const UCombatPredictedMovementComponent* PredictedMovement = GetLocalPredictedMovement();
+	const int32 InputSequence = PredictedMovement ? PredictedMovement->GetLastInputSequence() : INDEX_NONE;
 
-	// Velocity as array
-	TArray<TSharedPtr<FJsonValue>> VelArray;
-	VelArray.Add(MakeShareable(new FJsonValueNumber(State.Velocity.X)));
-	VelArray.Add(MakeShareable(new FJsonValueNumber(State.Velocity.Y)));
-	VelArray.Add(MakeShareable(new FJsonValueNumber(State.Velocity.Z)));
-	Data->SetArrayField(TEXT("velocity"), VelArray);
+	// Delta protocol: only the fields that changed since the server's last ack
+	if (ActiveProtocol == ECombatWireProtocol::BinaryDelta)
+	{
+		SendPlayerStateDelta(StampedState, InputSequence);
+		return;
+	}
+
+	// Binary protocol: one compact frame, no JSON DOM
+	if (ActiveProtocol == ECombatWireProtocol::Binary)
+	{
+		FCombatNetworkCodec::EncodeStateUpdate(BinarySendBuffer, StampedState, InputSequence);
+		WebSocket->Send(BinarySendBuffer.GetData(), BinarySendBuffer.Num(), true);
+		return;
+	}
+
+	FCombatJsonWriter& Writer = BeginMessage("state_update");
+
+	// Position, rotation and velocity as arrays
+	Writer.Key("position");
+	Writer.Vector(StampedState.Position);
+
+	Writer.Key("rotation");
+	Writer.BeginArray();
+	Writer.Number(StampedState.Rotation.Pitch);
+	Writer.Number(StampedState.Rotation.Yaw);
+	Writer.Number(StampedState.Rotation.Roll);
+	Writer.EndArray();
+
+	Writer.Key("velocity");
+	Writer.Vector(StampedState.Velocity);
 
 	// Other state
-	Data->SetNumberField(TEXT("anim_state"), static_cast<int32>(State.AnimState));
-	Data->SetNumberField(TEXT("combo_stage"), State.ComboStage);
-	Data->SetNumberField(TEXT("charge_progress"), State.ChargeProgress);
-	Data->SetNumberField(TEXT("hp"), State.CurrentHP);
-	Data->SetNumberField(TEXT("max_hp"), State.MaxHP);
+	Writer.Key("anim_state");
+	Writer.Number(static_cast<int32>(StampedState.AnimState));
+	Writer.Key("combo_stage");
+	Writer.Number(StampedState.ComboStage);
+	Writer.Key("charge_progress");
+	Writer.Number(StampedState.ChargeProgress);
+	Writer.Key("hp");
+	Writer.Number(StampedState.CurrentHP);
+	Writer.Key("max_hp");
+	Writer.Number(StampedState.MaxHP);
+	Writer.Key("timestamp");
+	Writer.Number(StampedState.Timestamp);
+	if (InputSequence != INDEX_NONE)
+	{
+		Writer.Key("input_seq");
+		Writer.Number(InputSequence);
+	}
 
-	SendMessage(TEXT("state_update"), Data);
+	QueueMessage();
 }
 
 void UCombatNetworkSubsystem::SetRemotePlayerClass(TSubclassOf<ACombatRemotePlayer> InClass)
@@ -138,6 +270,11 @@ void UCombatNetworkSubsystem::SetLocalPlayerCharacter(ACombatCharacter* InCharac
 	LocalPlayerCharacter = InCharacter;
 }
 
+UCombatPredictedMovementComponent* UCombatNetworkSubsystem::GetLocalPredictedMovement() const
+{
+	return LocalPlayerCharacter.IsValid() ? Cast<UCombatPredictedMovementComponent>(LocalPlayerCharacter->GetCharacterMovement()) : nullptr;
+}
+
 void UCombatNetworkSubsystem::StartNetworkTick(float TickRate)
 {
 	UWorld* World = GetWorld();
@@ -173,9 +310,44 @@ void UCombatNetworkSubsystem::OnConnected()
 	bIsConnected = true;
 
 	// Send join message
-	TSharedPtr<FJsonObject> Data = MakeShareable(new FJsonObject());
-	Data->SetStringField(TEXT("name"), TEXT("Player"));
-	SendMessage(TEXT("join"), Data);
+	FCombatJsonWriter& Writer = BeginMessage("join");
+	Writer.Key("name");
+	Writer.String(TEXTVIEW("Player"));
+
+	// Offer the wire protocols we accept, most preferred first. JSON is always accepted as a fallback
+	Writer.Key("protocols");
+	Writer.BeginArray();
+	const UCombatNetworkSettings* Settings = GetDefault<UCombatNetworkSettings>();
+	if (Settings->bPreferBinaryProtocol)
+	{
+		if (Settings->bUseDeltaCompression)
+		{
+			Writer.String(FStringView(CombatNetProtocol::BinaryDeltaName));
+		}
+		Writer.String(FStringView(CombatNetProtocol::BinaryName));
+	}
+	Writer.String(FStringView(CombatNetProtocol::JsonName));
+	Writer.EndArray();
+
+	// Ask for compact player ids; servers that don't know the field keep naming players by string
+	if (Settings->bUseNetIds)
+	{
+		Writer.Key("net_ids");
+		Writer.Bool(true);
+	}
+
+	// Advertise our opcode table so the server can send "op" instead of repeating the type name
+	Writer.Key("opcodes");
+	Writer.BeginObject();
+	for (int32 Opcode = 0; Opcode < MessageDispatcher.Num(); ++Opcode)
+	{
+		Writer.Key(MessageDispatcher.GetTypeName(Opcode));
+		Writer.Number(Opcode);
+	}
+	Writer.EndObject();
+
+	// Nothing else can usefully be sent before the handshake, so don't wait for the end of the frame
+	QueueMessage(true);
 
 	OnConnectionChanged.Broadcast(true);
 }
@@ -191,97 +363,293 @@ void UCombatNetworkSubsystem::OnClosed(int32 StatusCode, const FString& Reason,
 {
 	UE_LOG(LogCombatNetwork, Log, TEXT("Connection closed: %s (code %d)"), *Reason, StatusCode);
 	bIsConnected = false;
+	ResetProtocolState();
 
-	// Destroy all remote players
-	for (auto& Pair : RemotePlayers)
-	{
-		if (Pair.Value)
-		{
-			Pair.Value->Destroy();
-		}
-	}
-	RemotePlayers.Empty();
+	// Keep the pawns for when players show up again
+	ReleaseAllRemotePlayers();
 
 	OnConnectionChanged.Broadcast(false);
 }
 
-void UCombatNetworkSubsystem::OnMessage(const FString& Message)
+void UCombatNetworkSubsystem::OnRawMessage(const void* Data, SIZE_T Size, SIZE_T BytesRemaining)
 {
-	TSharedPtr<FJsonObject> JsonObject;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
-
-	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	// Text frames stay UTF-8 from the socket to the decoder; unfragmented ones skip the reassembly buffer
+	if (BytesRemaining == 0 && TextReceiveBuffer.Num() == 0)
 	{
-		UE_LOG(LogCombatNetwork, Warning, TEXT("Failed to parse message: %s"), *Message);
+		InboundPipeline->EnqueueText(static_cast<const uint8*>(Data), static_cast<int32>(Size));
 		return;
 	}
 
-	FString MessageType;
-	if (!JsonObject->TryGetStringField(TEXT("type"), MessageType))
+	TextReceiveBuffer.Append(static_cast<const uint8*>(Data), static_cast<int32>(Size));
+
+	if (BytesRemaining == 0)
+	{
+		InboundPipeline->EnqueueText(TextReceiveBuffer.GetData(), TextReceiveBuffer.Num());
+		TextReceiveBuffer.Reset();
+	}
+}
+
+void UCombatNetworkSubsystem::OnBinaryMessage(const void* Data, SIZE_T Size, bool bIsLastFragment)
+{
+	// Fast path: unfragmented frames are copied straight into a decode buffer
+	if (bIsLastFragment && BinaryReceiveBuffer.Num() == 0)
 	{
-		UE_LOG(LogCombatNetwork, Warning, TEXT("Message missing type field"));
+		InboundPipeline->EnqueueBinary(static_cast<const uint8*>(Data), static_cast<int32>(Size));
 		return;
 	}
 
-	// Get data object (may not exist for all message types)
-	TSharedPtr<FJsonObject> Data = JsonObject->GetObjectField(TEXT("data"));
+	BinaryReceiveBuffer.Append(static_cast<const uint8*>(Data), static_cast<int32>(Size));
 
-	if (MessageType == TEXT("join_response"))
+	if (bIsLastFragment)
 	{
-		HandleJoinResponse(Data);
+		InboundPipeline->EnqueueBinary(BinaryReceiveBuffer.GetData(), BinaryReceiveBuffer.Num());
+		BinaryReceiveBuffer.Reset();
 	}
-	else if (MessageType == TEXT("player_joined"))
+}
+
+void UCombatNetworkSubsystem::OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
 	{
-		HandlePlayerJoined(Data);
+		DrainInboundMessages();
+		UpdateRelevanceViewer();
+		DematerializeIrrelevantRemotePlayers();
+		SpawnPendingRemotePlayers();
+		ProbeServerClock();
+
+		JitterBuffer.Update(DeltaSeconds);
+		NetworkStats.InterpolationDelay = JitterBuffer.GetDelay();
+		NetworkStats.InterArrivalMean = JitterBuffer.GetInterArrivalMean();
+		NetworkStats.InterArrivalDeviation = JitterBuffer.GetInterArrivalDeviation();
+		NetworkStats.LateStateRatio = JitterBuffer.GetLateRatio();
 	}
-	else if (MessageType == TEXT("player_state"))
+}
+
+void UCombatNetworkSubsystem::DrainInboundMessages()
+{
+	// Everything decoded so far queues up behind whatever the last frame's budget left over
+	while (FCombatInboundFrame* Frame = InboundPipeline->Dequeue())
 	{
-		HandlePlayerState(Data);
+		PendingInboundFrames.Add(Frame);
 	}
-	else if (MessageType == TEXT("player_left"))
+
+	if (PendingInboundFrames.Num() == 0)
 	{
-		HandlePlayerLeft(Data);
+		return;
 	}
-	else if (MessageType == TEXT("position_correction"))
+
+	// Knowing the newest queued state per player lets HandlePlayerState skip the stale ones it reaches first
+	IndexPendingStates();
+
+	const double BudgetSeconds = GetDefault<UCombatNetworkSettings>()->InboundBudgetMs * 0.001;
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Handlers may disconnect, which discards the pending frames. The batch is owned here while it is
+	// dispatched, so a disconnect only stops the loop and never releases a frame out from under it
+	check(DrainingInboundFrames.Num() == 0);
+	Swap(DrainingInboundFrames, PendingInboundFrames);
+	const uint32 Generation = InboundPipeline->GetGeneration();
+
+	// At least one message is handled per frame, so a tiny budget slows the stream down but never stalls it
+	int32 NumHandled = 0;
+	while (NumHandled < DrainingInboundFrames.Num())
 	{
-		HandlePositionCorrection(Data);
+		MessageDispatcher.Dispatch(DrainingInboundFrames[NumHandled]->Message);
+		++NumHandled;
+
+		// The rest of the batch belongs to a connection that is gone
+		if (InboundPipeline->GetGeneration() != Generation)
+		{
+			NumHandled = DrainingInboundFrames.Num();
+			break;
+		}
+
+		// Whatever is left waits for the next frame, still in arrival order
+		if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+		{
+			break;
+		}
 	}
-	else if (MessageType == TEXT("damage"))
+
+	// Released only now, as the index points into frames up to the end of the batch
+	NewestPendingStateTimesByNetId.Reset();
+	NewestPendingStateTimes.Reset();
+	for (int32 Index = 0; Index < NumHandled; ++Index)
 	{
-		HandleDamage(Data);
+		InboundPipeline->Release(DrainingInboundFrames[Index]);
 	}
-	else if (MessageType == TEXT("respawn"))
+	DrainingInboundFrames.RemoveAt(0, NumHandled, EAllowShrinking::No);
+
+	// Nothing is added to the pending frames while draining, so the leftovers go back as they were
+	check(PendingInboundFrames.Num() == 0);
+	Swap(DrainingInboundFrames, PendingInboundFrames);
+}
+
+void UCombatNetworkSubsystem::IndexPendingStates()
+{
+	NewestPendingStateTimesByNetId.Reset();
+	NewestPendingStateTimes.Reset();
+
+	auto NoteState = [this](uint32 NetId, FUtf8StringView PlayerId, double Timestamp)
+	{
+		double& Newest = HasNetId(NetId) ? NewestPendingStateTimesByNetId.FindOrAdd(NetId, Timestamp) : NewestPendingStateTimes.FindOrAdd(PlayerId, Timestamp);
+		Newest = FMath::Max(Newest, Timestamp);
+	};
+
+	for (const FCombatInboundFrame* Frame : PendingInboundFrames)
 	{
-		HandleRespawn(Data);
+		const FCombatInboundMessage& Message = Frame->Message;
+		if (Message.Opcode == PlayerStateOpcode)
+		{
+			const FCombatPlayerStateMessage& StateMessage = Message.Get<FCombatPlayerStateMessage>();
+			NoteState(StateMessage.NetId, StateMessage.PlayerId, StateMessage.State.Timestamp);
+		}
+		else if (Message.Opcode == WorldSnapshotOpcode)
+		{
+			for (int32 Index = 0; Index < Message.Snapshot->Num(); ++Index)
+			{
+				NoteState(Message.Snapshot->GetNetId(Index), Message.Snapshot->GetPlayerId(Index), Message.Snapshot->Timestamp);
+			}
+		}
 	}
-	else
+}
+
+void UCombatNetworkSubsystem::DiscardPendingInboundFrames()
+{
+	for (FCombatInboundFrame* Frame : PendingInboundFrames)
 	{
-		UE_LOG(LogCombatNetwork, Warning, TEXT("Unknown message type: %s"), *MessageType);
+		InboundPipeline->Release(Frame);
 	}
+	PendingInboundFrames.Reset();
+	NewestPendingStateTimesByNetId.Reset();
+	NewestPendingStateTimes.Reset();
 }
 
-void UCombatNetworkSubsystem::HandleJoinResponse(const TSharedPtr<FJsonObject>& Data)
+void UCombatNetworkSubsystem::SendPlayerStateDelta(const FCombatNetworkState& State, int32 InputSequence)
 {
-	if (!Data.IsValid())
+	const uint16 Sequence = OutgoingStateSequence++;
+	const FCombatQuantizedState Quantized = FCombatQuantizedState::Quantize(State, ZoneOrigin);
+
+	// Delta against the newest state the server acknowledged, if we still remember it
+	static const FCombatQuantizedState ZeroBaseline;
+	const FCombatQuantizedState* Baseline = &ZeroBaseline;
+	uint8 BaselineAge = 0;
+	if (LastAckedOutgoingSequence != INDEX_NONE)
+	{
+		const uint16 AckedSequence = static_cast<uint16>(LastAckedOutgoingSequence);
+		const uint16 Age = static_cast<uint16>(Sequence - AckedSequence);
+		if (Age > 0 && Age < FCombatStateHistory::Capacity)
+		{
+			if (const FCombatQuantizedState* AckedState = SentStateHistory.Find(AckedSequence))
+			{
+				Baseline = AckedState;
+				BaselineAge = static_cast<uint8>(Age);
+			}
+		}
+	}
+
+	BinarySendBuffer.Reset();
+	FCombatByteWriter Writer(BinarySendBuffer);
+	FCombatNetworkCodec::WriteHeader(Writer, ECombatBinaryOpcode::StateDelta);
+	Writer.WriteUInt16(Sequence);
+	Writer.WriteUInt8(BaselineAge);
+	FCombatNetworkCodec::WriteStateDelta(Writer, Quantized, *Baseline);
+	FCombatNetworkCodec::WriteInputSequence(Writer, InputSequence);
+
+	SentStateHistory.Store(Sequence, Quantized);
+
+	WebSocket->Send(BinarySendBuffer.GetData(), BinarySendBuffer.Num(), true);
+}
+
+void UCombatNetworkSubsystem::SendRemoteStateAcks()
+{
+	if (ActiveProtocol != ECombatWireProtocol::BinaryDelta)
+	{
+		return;
+	}
+
+	InboundPipeline->TakeStateAcks(OutgoingStateAcks);
+	if (OutgoingStateAcks.Num() == 0)
 	{
 		return;
 	}
 
-	LocalPlayerId = Data->GetStringField(TEXT("player_id"));
+	FCombatNetworkCodec::EncodeRemoteStateAck(BinarySendBuffer, OutgoingStateAcks, LocalNetId != CombatNetProtocol::InvalidNetId);
+	WebSocket->Send(BinarySendBuffer.GetData(), BinarySendBuffer.Num(), true);
+}
+
+void UCombatNetworkSubsystem::ResetProtocolState()
+{
+	ActiveProtocol = ECombatWireProtocol::Json;
+	LocalNetId = CombatNetProtocol::InvalidNetId;
+	TextReceiveBuffer.Reset();
+	BinaryReceiveBuffer.Reset();
+	NumOutboundMessages = 0;
+	bStateSendRequested = false;
+
+	ZoneOrigin = FVector::ZeroVector;
+	OutgoingStateSequence = 0;
+	OutgoingCombatEventSequence = 0;
+	LastAckedOutgoingSequence = INDEX_NONE;
+	OutgoingStateAcks.Reset();
+	SentStateHistory.Reset();
+	StateSendPolicy.Reset();
+	ClockSync.Reset();
+	JitterBuffer.Reset();
+
+	if (UCombatPredictedMovementComponent* PredictedMovement = GetLocalPredictedMovement())
+	{
+		PredictedMovement->ResetPrediction();
+	}
+
+	if (InboundPipeline)
+	{
+		DiscardPendingInboundFrames();
+		InboundPipeline->Reset();
+	}
+}
+
+void UCombatNetworkSubsystem::HandleJoinResponse(const FCombatJoinResponseMessage& Message)
+{
+	LocalPlayerId = FString(Message.PlayerId);
 	UE_LOG(LogCombatNetwork, Log, TEXT("Joined server with ID: %s"), *LocalPlayerId);
 
+	// Servers that assign net ids name players by them from here on; others keep using string ids
+	LocalNetId = Message.NetId;
+	if (LocalNetId != CombatNetProtocol::InvalidNetId)
+	{
+		UE_LOG(LogCombatNetwork, Log, TEXT("Using net id %u"), LocalNetId);
+	}
+
+	// Servers that predate protocol negotiation don't send this field and keep us on JSON
+	const FString Protocol(Message.Protocol);
+	if (Protocol == CombatNetProtocol::BinaryDeltaName)
+	{
+		ActiveProtocol = ECombatWireProtocol::BinaryDelta;
+	}
+	else if (Protocol == CombatNetProtocol::BinaryName)
+	{
+		ActiveProtocol = ECombatWireProtocol::Binary;
+	}
+	else
+	{
+		ActiveProtocol = ECombatWireProtocol::Json;
+	}
+	UE_LOG(LogCombatNetwork, Log, TEXT("Using %s wire protocol"), *UEnum::GetValueAsString(ActiveProtocol));
+
+	// Delta-protocol positions are quantized relative to the zone origin
+	ZoneOrigin = Message.ZoneOrigin;
+
 	// Debug: Check if LocalPlayerCharacter is valid
 	UE_LOG(LogCombatNetwork, Log, TEXT("LocalPlayerCharacter valid: %s"), LocalPlayerCharacter.IsValid() ? TEXT("YES") : TEXT("NO"));
 
 	// Server sends X/Y spawn position, we find Z via ground trace
-	const TArray<TSharedPtr<FJsonValue>>* SpawnPosArray;
-	bool bHasSpawnPos = Data->TryGetArrayField(TEXT("spawn_position"), SpawnPosArray) && SpawnPosArray->Num() >= 2;
-	UE_LOG(LogCombatNetwork, Log, TEXT("Has spawn_position array: %s"), bHasSpawnPos ? TEXT("YES") : TEXT("NO"));
+	UE_LOG(LogCombatNetwork, Log, TEXT("Has spawn_position array: %s"), Message.bHasSpawnPosition ? TEXT("YES") : TEXT("NO"));
 
-	if (bHasSpawnPos)
+	if (Message.bHasSpawnPosition)
 	{
-		float SpawnX = (*SpawnPosArray)[0]->AsNumber();
-		float SpawnY = (*SpawnPosArray)[1]->AsNumber();
+		float SpawnX = Message.SpawnPosition.X;
+		float SpawnY = Message.SpawnPosition.Y;
 		UE_LOG(LogCombatNetwork, Log, TEXT("Server spawn position: X=%.1f Y=%.1f"), SpawnX, SpawnY);
 
 		if (LocalPlayerCharacter.IsValid())
@@ -289,22 +657,14 @@ void UCombatNetworkSubsystem::HandleJoinResponse(const TSharedPtr<FJsonObject>&
 			UWorld* World = GetWorld();
 			if (World)
 			{
-				// Trace down from high up to find the ground
-				FVector TraceStart(SpawnX, SpawnY, 50000.0f);
-				FVector TraceEnd(SpawnX, SpawnY, -50000.0f);
-
-				FHitResult HitResult;
-				FCollisionQueryParams QueryParams;
-				QueryParams.AddIgnoredActor(LocalPlayerCharacter.Get());
-
 				float SpawnZ = 0.0f;
-				// Use WorldStatic channel which hits terrain/floors reliably
-				if (World->LineTraceSingleByChannel(HitResult, TraceStart, TraceEnd, ECC_WorldStatic, QueryParams))
+				double GroundZ = 0.0;
+				if (FindGroundHeight(FVector(SpawnX, SpawnY, 0.0f), GroundZ))
 				{
 					// Spawn above ground - use capsule half height to avoid clipping
 					float CapsuleHalfHeight = LocalPlayerCharacter->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
-					SpawnZ = HitResult.Location.Z + CapsuleHalfHeight + 10.0f;
-					UE_LOG(LogCombatNetwork, Log, TEXT("Ground trace hit at Z=%.1f, spawning at Z=%.1f"), HitResult.Location.Z, SpawnZ);
+					SpawnZ = GroundZ + CapsuleHalfHeight + 10.0f;
+					UE_LOG(LogCombatNetwork, Log, TEXT("Ground found at Z=%.1f, spawning at Z=%.1f"), GroundZ, SpawnZ);
 				}
 				else
 				{
@@ -324,171 +684,207 @@ void UCombatNetworkSubsystem::HandleJoinResponse(const TSharedPtr<FJsonObject>&
 	StartNetworkTick(20.0f);
 }
 
-void UCombatNetworkSubsystem::HandlePlayerJoined(const TSharedPtr<FJsonObject>& Data)
+void UCombatNetworkSubsystem::HandlePlayerJoined(const FCombatPlayerJoinedMessage& Message)
 {
-	if (!Data.IsValid())
+	// A reused net id whose previous player's player_left went missing belongs to someone new now
+	const int32 NetIdSlot = static_cast<int32>(Message.NetId);
+	if (HasNetId(Message.NetId) && RemotePlayerSlots.IsValidIndex(NetIdSlot))
 	{
-		return;
+		const FCombatRemotePlayerSlot& Previous = RemotePlayerSlots[NetIdSlot];
+		if (Previous.bInUse && !Previous.PlayerId.IsEmpty() && !Message.PlayerId.IsEmpty() && Previous.PlayerId != FString(Message.PlayerId))
+		{
+			ReleaseRemotePlayer(NetIdSlot);
+		}
 	}
 
-	FString PlayerId = Data->GetStringField(TEXT("player_id"));
-
-	// Don't process ourselves
-	if (PlayerId == LocalPlayerId)
+	// Don't process ourselves, or a message that names no one
+	const int32 Slot = FindOrAddRemotePlayerSlot(Message.NetId, Message.PlayerId);
+	if (Slot == INDEX_NONE)
 	{
 		return;
 	}
 
-	// Get spawn X/Y from server, find Z via ground trace
-	FVector SpawnPosition = FVector::ZeroVector;
-	const TArray<TSharedPtr<FJsonValue>>* PosArray;
-	if (Data->TryGetArrayField(TEXT("position"), PosArray) && PosArray->Num() >= 2)
+	FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+	if (Entry.Pawn)
 	{
-		SpawnPosition.X = (*PosArray)[0]->AsNumber();
-		SpawnPosition.Y = (*PosArray)[1]->AsNumber();
-
-		// Find ground Z using WorldStatic trace
-		UWorld* World = GetWorld();
-		if (World)
-		{
-			FVector TraceStart(SpawnPosition.X, SpawnPosition.Y, 50000.0f);
-			FVector TraceEnd(SpawnPosition.X, SpawnPosition.Y, -50000.0f);
-
-			FHitResult HitResult;
-			FCollisionQueryParams QueryParams;
-
-			if (World->LineTraceSingleByChannel(HitResult, TraceStart, TraceEnd, ECC_WorldStatic, QueryParams))
-			{
-				// 100 units above ground for remote players (no capsule ref yet)
-				SpawnPosition.Z = HitResult.Location.Z + 100.0f;
-			}
-		}
+		return;
 	}
 
-	UE_LOG(LogCombatNetwork, Log, TEXT("Player joined: %s at position X=%.1f Y=%.1f Z=%.1f"),
-		*PlayerId, SpawnPosition.X, SpawnPosition.Y, SpawnPosition.Z);
-
-	// Spawn the remote player immediately at the calculated position
-	SpawnRemotePlayer(PlayerId, SpawnPosition);
+	UE_LOG(LogCombatNetwork, Log, TEXT("Player joined: %s at position X=%.1f Y=%.1f"),
+		*Entry.PlayerId, Message.Position.X, Message.Position.Y);
 
-	OnRemotePlayerJoined.Broadcast(PlayerId, SpawnPosition);
+	// Spawned by SpawnPendingRemotePlayers, nearest first, within the frame's budget. The ground
+	// under the server's X/Y is traced for then, unless a state says where the player is first
+	if (Message.bHasPosition)
+	{
+		Entry.Pending.JoinPosition = FVector(Message.Position.X, Message.Position.Y, 0.0);
+		Entry.Pending.bJoinHeightKnown = false;
+	}
 }
 
-void UCombatNetworkSubsystem::HandlePlayerState(const TSharedPtr<FJsonObject>& Data)
+void UCombatNetworkSubsystem::HandlePlayerState(const FCombatPlayerStateMessage& Message)
 {
-	if (!Data.IsValid())
+	const FCombatNetworkState& State = Message.State;
+
+	// Ignore our own state. Players we haven't heard of yet are added
+	const int32 Slot = FindOrAddRemotePlayerSlot(Message.NetId, Message.PlayerId);
+	if (Slot == INDEX_NONE)
 	{
 		return;
 	}
 
-	FString PlayerId = Data->GetStringField(TEXT("player_id"));
+	FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+
+	// A newer state for this player is queued behind this one. Only the animation transition can't be
+	// recovered from it, so play that (in order) and skip the rest of the stale state
+	const double* NewestPendingTime = HasNetId(Message.NetId) ? NewestPendingStateTimesByNetId.Find(Message.NetId) : NewestPendingStateTimes.Find(Message.PlayerId);
+	if (NewestPendingTime && State.Timestamp < *NewestPendingTime)
+	{
+		if (Entry.Pawn)
+		{
+			Entry.Pawn->ApplyAnimationState(State.AnimState, State.ComboStage);
+		}
+		++NetworkStats.RedundantStatesDropped;
+		return;
+	}
 
-	// Ignore our own state
-	if (PlayerId == LocalPlayerId)
+	if (!Entry.Pawn)
 	{
+		// Player has no pawn yet. Keep its newest states, enough to fill an interpolation buffer, for when it spawns
+		FCombatPendingRemotePlayer& Pending = Entry.Pending;
+		if (Pending.States.Num() == FCombatInterpolationBuffer::Capacity)
+		{
+			Pending.States.RemoveAt(0, 1, EAllowShrinking::No);
+		}
+		Pending.States.Add(State);
 		return;
 	}
 
-	// Find or spawn the remote player
-	ACombatRemotePlayer** FoundPlayer = RemotePlayers.Find(PlayerId);
-	ACombatRemotePlayer* RemotePlayer = nullptr;
+	// Apply state to remote player
+	Entry.Pawn->ApplyNetworkState(State);
+	++NetworkStats.StatesApplied;
+}
 
-	if (FoundPlayer && *FoundPlayer)
+void UCombatNetworkSubsystem::HandleWorldSnapshot(const FCombatWorldSnapshot& Snapshot)
+{
+	// One frame, one pass: no envelope, dispatch or decode per player
+	FCombatPlayerStateMessage Entry;
+	for (int32 Index = 0; Index < Snapshot.Num(); ++Index)
 	{
-		RemotePlayer = *FoundPlayer;
+		Entry.NetId = Snapshot.GetNetId(Index);
+		Entry.PlayerId = Snapshot.GetPlayerId(Index);
+		Snapshot.GetState(Index, Entry.State);
+		HandlePlayerState(Entry);
 	}
-	else
+}
+
+void UCombatNetworkSubsystem::HandleStateAck(const FCombatStateAckMessage& Message)
+{
+	if (LastAckedOutgoingSequence == INDEX_NONE || CombatNetProtocol::IsSequenceNewer(Message.Sequence, static_cast<uint16>(LastAckedOutgoingSequence)))
 	{
-		// Player doesn't exist yet, spawn them
-		FVector Position = FVector::ZeroVector;
-		const TArray<TSharedPtr<FJsonValue>>* PosArray;
-		if (Data->TryGetArrayField(TEXT("position"), PosArray) && PosArray->Num() >= 3)
-		{
-			Position.X = (*PosArray)[0]->AsNumber();
-			Position.Y = (*PosArray)[1]->AsNumber();
-			Position.Z = (*PosArray)[2]->AsNumber();
-		}
-		RemotePlayer = SpawnRemotePlayer(PlayerId, Position);
+		LastAckedOutgoingSequence = Message.Sequence;
 	}
+}
 
-	if (!RemotePlayer)
+void UCombatNetworkSubsystem::HandleCombatEvent(const FCombatEventMessage& Message)
+{
+	const int32 Slot = FindRemotePlayerSlot(Message.NetId, Message.PlayerId);
+	if (Slot == INDEX_NONE)
 	{
 		return;
 	}
 
-	// Build network state from data
-	FCombatNetworkState State;
+	FCombatEvent Event;
+	Event.Type = Message.Type;
+	Event.ComboStage = Message.ComboStage;
+	Event.Sequence = Message.Sequence;
+	Event.Timestamp = Message.Timestamp;
+	Event.ReceiveTime = FPlatformTime::Seconds();
 
-	// Position
-	const TArray<TSharedPtr<FJsonValue>>* PosArray;
-	if (Data->TryGetArrayField(TEXT("position"), PosArray) && PosArray->Num() >= 3)
+	FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+	if (Entry.Pawn)
 	{
-		State.Position.X = (*PosArray)[0]->AsNumber();
-		State.Position.Y = (*PosArray)[1]->AsNumber();
-		State.Position.Z = (*PosArray)[2]->AsNumber();
+		Entry.Pawn->QueueCombatEvent(Event);
 	}
-
-	// Rotation
-	const TArray<TSharedPtr<FJsonValue>>* RotArray;
-	if (Data->TryGetArrayField(TEXT("rotation"), RotArray) && RotArray->Num() >= 3)
+	else
 	{
-		State.Rotation.Pitch = (*RotArray)[0]->AsNumber();
-		State.Rotation.Yaw = (*RotArray)[1]->AsNumber();
-		State.Rotation.Roll = (*RotArray)[2]->AsNumber();
+		// Played once the player gets a pawn, if they're still recent by then
+		TArray<FCombatEvent>& Events = Entry.Pending.Events;
+		if (Events.Num() == MaxKeptCombatEvents)
+		{
+			Events.RemoveAt(0, 1, EAllowShrinking::No);
+		}
+		Events.Add(Event);
 	}
+}
 
-	// Velocity
-	const TArray<TSharedPtr<FJsonValue>>* VelArray;
-	if (Data->TryGetArrayField(TEXT("velocity"), VelArray) && VelArray->Num() >= 3)
+void UCombatNetworkSubsystem::HandlePong(const FCombatPongMessage& Message, double ReceiveTime)
+{
+	if (!ClockSync.AddSample(Message.ClientTime, Message.ServerTime, ReceiveTime))
 	{
-		State.Velocity.X = (*VelArray)[0]->AsNumber();
-		State.Velocity.Y = (*VelArray)[1]->AsNumber();
-		State.Velocity.Z = (*VelArray)[2]->AsNumber();
+		UE_LOG(LogCombatNetwork, Verbose, TEXT("Rejected clock sample (sent %.3f, received %.3f)"), Message.ClientTime, ReceiveTime);
 	}
+}
 
-	// Animation state
-	State.AnimState = static_cast<ECombatAnimationState>(Data->GetIntegerField(TEXT("anim_state")));
-	State.ComboStage = Data->GetIntegerField(TEXT("combo_stage"));
-	State.ChargeProgress = Data->GetNumberField(TEXT("charge_progress"));
-	State.CurrentHP = Data->GetNumberField(TEXT("hp"));
-	State.MaxHP = Data->GetNumberField(TEXT("max_hp"));
-	State.Timestamp = Data->GetNumberField(TEXT("timestamp"));
+void UCombatNetworkSubsystem::AddStateArrival(double Timestamp, double ReceiveTime)
+{
+	const double ArrivalServerTime = ClockSync.IsSynchronized() ? ClockSync.GetServerTime(ReceiveTime) : 0.0;
+	JitterBuffer.AddArrival(Timestamp, ReceiveTime, ArrivalServerTime);
+}
 
-	// Apply state to remote player
-	RemotePlayer->ApplyNetworkState(State);
+void UCombatNetworkSubsystem::RecordInterpolationStats(int32 Underruns, double ExtrapolationTime)
+{
+	NetworkStats.InterpolationUnderruns += Underruns;
+	NetworkStats.ExtrapolationTime += ExtrapolationTime;
 }
 
-void UCombatNetworkSubsystem::HandlePlayerLeft(const TSharedPtr<FJsonObject>& Data)
+void UCombatNetworkSubsystem::ProbeServerClock()
 {
-	if (!Data.IsValid())
+	const double Now = FPlatformTime::Seconds();
+	if (!IsConnected() || !ClockSync.ShouldProbe(Now))
 	{
 		return;
 	}
 
-	FString PlayerId = Data->GetStringField(TEXT("player_id"));
-	UE_LOG(LogCombatNetwork, Log, TEXT("Player left: %s"), *PlayerId);
+	FCombatJsonWriter& Writer = BeginMessage("ping");
+	Writer.Key("client_time");
+	Writer.Number(Now);
 
-	DestroyRemotePlayer(PlayerId);
-	OnRemotePlayerLeft.Broadcast(PlayerId);
+	// Waiting for the end of the frame would add to the measured round trip
+	QueueMessage(true);
+	ClockSync.NotifyProbeSent(Now);
 }
 
-void UCombatNetworkSubsystem::HandlePositionCorrection(const TSharedPtr<FJsonObject>& Data)
+void UCombatNetworkSubsystem::HandlePlayerLeft(const FCombatPlayerLeftMessage& Message)
 {
-	if (!Data.IsValid())
+	const int32 Slot = FindRemotePlayerSlot(Message.NetId, Message.PlayerId);
+	if (Slot == INDEX_NONE)
 	{
 		return;
 	}
 
+	const FString PlayerId = RemotePlayerSlots[Slot].PlayerId;
+	UE_LOG(LogCombatNetwork, Log, TEXT("Player left: %s"), *PlayerId);
+
+	ReleaseRemotePlayer(Slot);
+	OnRemotePlayerLeft.Broadcast(PlayerId);
+}
+
+void UCombatNetworkSubsystem::HandlePositionCorrection(const FCombatPositionCorrectionMessage& Message)
+{
 	// Server is correcting our position (anti-cheat)
-	const TArray<TSharedPtr<FJsonValue>>* PosArray;
-	if (Data->TryGetArrayField(TEXT("position"), PosArray) && PosArray->Num() >= 3)
+	if (Message.bHasPosition)
 	{
-		FVector CorrectedPosition;
-		CorrectedPosition.X = (*PosArray)[0]->AsNumber();
-		CorrectedPosition.Y = (*PosArray)[1]->AsNumber();
-		CorrectedPosition.Z = (*PosArray)[2]->AsNumber();
+		const FVector CorrectedPosition = Message.Position;
 
-		if (LocalPlayerCharacter.IsValid())
+		if (UCombatPredictedMovementComponent* PredictedMovement = GetLocalPredictedMovement())
+		{
+			// Rewind to the server's position and replay the inputs it hasn't seen yet
+			PredictedMovement->Reconcile(CorrectedPosition, Message.bHasVelocity ? &Message.Velocity : nullptr, Message.InputSequence);
+			UE_LOG(LogCombatNetwork, Verbose, TEXT("Reconciled with server position X=%.1f Y=%.1f Z=%.1f at input %d"),
+				CorrectedPosition.X, CorrectedPosition.Y, CorrectedPosition.Z, Message.InputSequence);
+		}
+		else if (LocalPlayerCharacter.IsValid())
 		{
 			LocalPlayerCharacter->SetActorLocation(CorrectedPosition);
 			UE_LOG(LogCombatNetwork, Warning, TEXT("Position corrected by server to X=%.1f Y=%.1f Z=%.1f"),
@@ -497,12 +893,14 @@ void UCombatNetworkSubsystem::HandlePositionCorrection(const TSharedPtr<FJsonObj
 	}
 }
 
-ACombatRemotePlayer* UCombatNetworkSubsystem::SpawnRemotePlayer(const FString& PlayerId, const FVector& Position)
+ACombatRemotePlayer* UCombatNetworkSubsystem::SpawnRemotePlayer(int32 Slot, const FVector& Position)
 {
+	FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+
 	// Check if already spawned
-	if (RemotePlayers.Contains(PlayerId))
+	if (Entry.Pawn)
 	{
-		return RemotePlayers[PlayerId];
+		return Entry.Pawn;
 	}
 
 	// Need a valid class
@@ -512,87 +910,457 @@ ACombatRemotePlayer* UCombatNetworkSubsystem::SpawnRemotePlayer(const FString& P
 		return nullptr;
 	}
 
-	UWorld* World = GetWorld();
-	if (!World)
+	UCombatRemotePlayerPool* Pool = GetRemotePlayerPool();
+	if (!Pool)
 	{
 		return nullptr;
 	}
 
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-
 	UE_LOG(LogCombatNetwork, Log, TEXT("Spawning remote player at X=%.1f Y=%.1f Z=%.1f"), Position.X, Position.Y, Position.Z);
 
-	ACombatRemotePlayer* RemotePlayer = World->SpawnActor<ACombatRemotePlayer>(
-		RemotePlayerClass,
-		Position,
-		FRotator::ZeroRotator,
-		SpawnParams
-	);
-
+	bool bFromPool = false;
+	ACombatRemotePlayer* RemotePlayer = Pool->Acquire(RemotePlayerClass, Entry.PlayerId, Position, bFromPool);
 	if (RemotePlayer)
 	{
-		RemotePlayer->SetPlayerId(PlayerId);
-		RemotePlayers.Add(PlayerId, RemotePlayer);
-		UE_LOG(LogCombatNetwork, Log, TEXT("Spawned remote player: %s"), *PlayerId);
+		if (bFromPool)
+		{
+			++NetworkStats.RemotePlayerPoolHits;
+		}
+		else
+		{
+			++NetworkStats.RemotePlayerPoolMisses;
+		}
+
+		Entry.Pawn = RemotePlayer;
+		UE_LOG(LogCombatNetwork, Log, TEXT("Spawned remote player: %s%s"), *Entry.PlayerId, bFromPool ? TEXT(" (pooled)") : TEXT(""));
 	}
 
 	return RemotePlayer;
 }
 
-void UCombatNetworkSubsystem::DestroyRemotePlayer(const FString& PlayerId)
+void UCombatNetworkSubsystem::ReleaseRemotePlayer(int32 Slot)
+{
+	FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+
+	if (IsValid(Entry.Pawn))
+	{
+		if (UCombatRemotePlayerPool* Pool = GetRemotePlayerPool())
+		{
+			Pool->Release(Entry.Pawn);
+		}
+		else
+		{
+			Entry.Pawn->Destroy();
+		}
+	}
+
+	// The decode worker drops the baselines of players with a net id itself, in order with their
+	// player_left. Without net ids the client picked the slot, and it can be handed out again
+	if (LocalNetId == CombatNetProtocol::InvalidNetId)
+	{
+		InboundPipeline->ForgetPlayer(Entry.PlayerId);
+		FreeRemotePlayerSlots.Add(Slot);
+	}
+
+	RemotePlayerSlotsById.Remove(Entry.PlayerId);
+	Entry = FCombatRemotePlayerSlot();
+}
+
+void UCombatNetworkSubsystem::ReleaseAllRemotePlayers()
+{
+	UCombatRemotePlayerPool* Pool = GetRemotePlayerPool();
+	for (FCombatRemotePlayerSlot& Entry : RemotePlayerSlots)
+	{
+		if (!IsValid(Entry.Pawn))
+		{
+			continue;
+		}
+
+		if (Pool)
+		{
+			Pool->Release(Entry.Pawn);
+		}
+		else
+		{
+			Entry.Pawn->Destroy();
+		}
+	}
+	RemotePlayerSlots.Empty();
+	RemotePlayerSlotsById.Empty();
+	FreeRemotePlayerSlots.Empty();
+}
+
+ACombatRemotePlayer* UCombatNetworkSubsystem::FindRemotePlayer(const FString& PlayerId) const
+{
+	const int32* Slot = RemotePlayerSlotsById.Find(PlayerId);
+	return Slot ? RemotePlayerSlots[*Slot].Pawn.Get() : nullptr;
+}
+
+bool UCombatNetworkSubsystem::IsLocalPlayer(uint32 NetId, FUtf8StringView PlayerId) const
+{
+	if (HasNetId(NetId))
+	{
+		return NetId == LocalNetId;
+	}
+	return !PlayerId.IsEmpty() && FString(PlayerId) == LocalPlayerId;
+}
+
+int32 UCombatNetworkSubsystem::FindRemotePlayerSlot(uint32 NetId, FUtf8StringView PlayerId) const
+{
+	// The net id is the slot: no hashing, no string
+	if (HasNetId(NetId))
+	{
+		const int32 Slot = static_cast<int32>(NetId);
+		return RemotePlayerSlots.IsValidIndex(Slot) && RemotePlayerSlots[Slot].bInUse ? Slot : INDEX_NONE;
+	}
+
+	if (PlayerId.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	const int32* Slot = RemotePlayerSlotsById.Find(FString(PlayerId));
+	return Slot ? *Slot : INDEX_NONE;
+}
+
+int32 UCombatNetworkSubsystem::FindOrAddRemotePlayerSlot(uint32 NetId, FUtf8StringView PlayerId)
+{
+	if (IsLocalPlayer(NetId, PlayerId))
+	{
+		return INDEX_NONE;
+	}
+
+	int32 Slot = FindRemotePlayerSlot(NetId, PlayerId);
+	if (Slot == INDEX_NONE)
+	{
+		if (HasNetId(NetId))
+		{
+			if (NetId > CombatNetProtocol::MaxNetId)
+			{
+				UE_LOG(LogCombatNetwork, Warning, TEXT("Ignoring player with out of range net id %u"), NetId);
+				return INDEX_NONE;
+			}
+
+			Slot = static_cast<int32>(NetId);
+			if (Slot >= RemotePlayerSlots.Num())
+			{
+				RemotePlayerSlots.SetNum(Slot + 1);
+			}
+		}
+		else if (PlayerId.IsEmpty())
+		{
+			return INDEX_NONE;
+		}
+		else
+		{
+			Slot = FreeRemotePlayerSlots.Num() > 0 ? FreeRemotePlayerSlots.Pop(EAllowShrinking::No) : RemotePlayerSlots.AddDefaulted();
+		}
+
+		FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+		Entry.bInUse = true;
+		Entry.Pending.Order = NextPendingRemotePlayerOrder++;
+	}
+
+	// Players referred to by net id get their string id from the first message that names them
+	FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+	if (Entry.PlayerId.IsEmpty() && !PlayerId.IsEmpty())
+	{
+		Entry.PlayerId = FString(PlayerId);
+		RemotePlayerSlotsById.Add(Entry.PlayerId, Slot);
+	}
+	return Slot;
+}
+
+void UCombatNetworkSubsystem::UpdateRelevanceViewer()
+{
+	const APlayerController* PlayerController = LocalPlayerCharacter.IsValid() ? Cast<APlayerController>(LocalPlayerCharacter->GetController()) : nullptr;
+	if (!GetDefault<UCombatNetworkSettings>()->bUseRelevance || !PlayerController)
+	{
+		RelevanceFilter.ClearViewer();
+		return;
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	const float FieldOfView = PlayerController->PlayerCameraManager ? PlayerController->PlayerCameraManager->GetFOVAngle() : 90.0f;
+
+	RelevanceFilter.SetViewer(LocalPlayerCharacter->GetActorLocation(), ViewLocation, ViewRotation, FieldOfView);
+}
+
+void UCombatNetworkSubsystem::DematerializeIrrelevantRemotePlayers()
+{
+	UCombatRemotePlayerPool* Pool = GetRemotePlayerPool();
+	for (FCombatRemotePlayerSlot& Entry : RemotePlayerSlots)
+	{
+		ACombatRemotePlayer* RemotePlayer = Entry.Pawn;
+		if (!IsValid(RemotePlayer) || RelevanceFilter.IsRelevant(RemotePlayer->GetActorLocation(), true))
+		{
+			continue;
+		}
+
+		// Keep the player as data from its newest state on. Its delta baselines stay, as states keep coming
+		FCombatPendingRemotePlayer& Pending = Entry.Pending;
+		Pending.JoinPosition = RemotePlayer->GetActorLocation();
+		Pending.bJoinHeightKnown = true;
+		Pending.States.Reset();
+		Pending.States.Add(RemotePlayer->GetLastNetworkState());
+		Entry.Pawn = nullptr;
+
+		if (Pool)
+		{
+			Pool->Release(RemotePlayer);
+		}
+		else
+		{
+			RemotePlayer->Destroy();
+		}
+		++NetworkStats.RemotePlayersDematerialized;
+	}
+}
+
+void UCombatNetworkSubsystem::SpawnPendingRemotePlayers()
+{
+	// Nearest first: those are the players the local player sees and fights. Without a local
+	// character, in the order they were heard of
+	struct FSpawnCandidate
+	{
+		int32 Slot;
+		double DistanceSq;
+		uint32 Order;
+	};
+
+	const bool bHasOrigin = LocalPlayerCharacter.IsValid();
+	const FVector Origin = bHasOrigin ? LocalPlayerCharacter->GetActorLocation() : FVector::ZeroVector;
+
+	int32 NumPawns = 0;
+	int32 NumDataOnly = 0;
+	TArray<FSpawnCandidate, TInlineAllocator<16>> Candidates;
+	for (int32 Slot = 0; Slot < RemotePlayerSlots.Num(); ++Slot)
+	{
+		const FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+		if (!Entry.bInUse)
+		{
+			continue;
+		}
+
+		if (Entry.Pawn)
+		{
+			++NumPawns;
+			continue;
+		}
+		++NumDataOnly;
+
+		// A player spawns once the server has named it, so delegates and Blueprint always see its id
+		const FVector Position = Entry.Pending.GetPosition();
+		if (Entry.PlayerId.IsEmpty() || !RelevanceFilter.IsRelevant(Position, false))
+		{
+			continue;
+		}
+
+		const double DistanceSq = bHasOrigin ? FVector::DistSquared2D(Position, Origin) : 0.0;
+		Candidates.Add({ Slot, DistanceSq, Entry.Pending.Order });
+	}
+	Candidates.Sort([](const FSpawnCandidate& A, const FSpawnCandidate& B)
+	{
+		return A.DistanceSq != B.DistanceSq ? A.DistanceSq < B.DistanceSq : A.Order < B.Order;
+	});
+
+	const double BudgetSeconds = GetDefault<UCombatNetworkSettings>()->SpawnBudgetMs * 0.001;
+	const double StartTime = FPlatformTime::Seconds();
+
+	// At least one spawn per frame, so a tiny budget slows the wave down but never stalls it
+	for (const FSpawnCandidate& Candidate : Candidates)
+	{
+		if (SpawnPendingRemotePlayer(Candidate.Slot))
+		{
+			++NumPawns;
+			--NumDataOnly;
+		}
+
+		if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+		{
+			break;
+		}
+	}
+
+	NetworkStats.RemotePlayerPawns = NumPawns;
+	NetworkStats.DataOnlyRemotePlayers = NumDataOnly;
+}
+
+bool UCombatNetworkSubsystem::SpawnPendingRemotePlayer(int32 Slot)
+{
+	FCombatPendingRemotePlayer& Pending = RemotePlayerSlots[Slot].Pending;
+
+	// The newest state says where the player is; only a player we have no state for needs the ground found
+	FVector SpawnPosition = Pending.GetPosition();
+	if (Pending.States.Num() == 0 && !Pending.bJoinHeightKnown)
+	{
+		SpawnPosition.Z = FindSpawnHeight(SpawnPosition);
+	}
+
+	ACombatRemotePlayer* RemotePlayer = SpawnRemotePlayer(Slot, SpawnPosition);
+	if (!RemotePlayer)
+	{
+		return false;
+	}
+
+	// Catch up with what arrived while waiting, in order. The first state places the pawn
+	for (const FCombatNetworkState& State : Pending.States)
+	{
+		RemotePlayer->ApplyNetworkState(State);
+		++NetworkStats.StatesApplied;
+	}
+	const double Now = FPlatformTime::Seconds();
+	for (const FCombatEvent& Event : Pending.Events)
+	{
+		if (Now - Event.ReceiveTime <= MaxKeptCombatEventAge)
+		{
+			RemotePlayer->QueueCombatEvent(Event);
+		}
+	}
+
+	// Emptied rather than freed, for when the player stops being relevant
+	const bool bAnnounceJoin = !Pending.bJoinAnnounced;
+	Pending.bJoinAnnounced = true;
+	Pending.States.Reset();
+	Pending.Events.Reset();
+
+	if (bAnnounceJoin)
+	{
+		OnRemotePlayerJoined.Broadcast(RemotePlayerSlots[Slot].PlayerId, SpawnPosition);
+	}
+	return true;
+}
+
+double UCombatNetworkSubsystem::FindSpawnHeight(const FVector& Position) const
 {
-	ACombatRemotePlayer** FoundPlayer = RemotePlayers.Find(PlayerId);
-	if (FoundPlayer && *FoundPlayer)
+	double GroundZ = 0.0;
+	if (FindGroundHeight(Position, GroundZ))
 	{
-		(*FoundPlayer)->Destroy();
-		RemotePlayers.Remove(PlayerId);
+		// 100 units above ground for remote players (no capsule ref yet)
+		return GroundZ + 100.0;
 	}
+	return Position.Z;
+}
+
+bool UCombatNetworkSubsystem::FindGroundHeight(const FVector& Position, double& OutGroundZ) const
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return false;
+	}
+
+	if (UCombatGroundHeightGrid* Grid = World->GetSubsystem<UCombatGroundHeightGrid>())
+	{
+		return Grid->FindGroundHeight(Position, OutGroundZ);
+	}
+	return UCombatGroundHeightGrid::TraceGroundHeight(World, Position, OutGroundZ);
+}
+
+UCombatRemotePlayerPool* UCombatNetworkSubsystem::GetRemotePlayerPool() const
+{
+	UWorld* World = GetWorld();
+	return World ? World->GetSubsystem<UCombatRemotePlayerPool>() : nullptr;
 }
 
 void UCombatNetworkSubsystem::NetworkTick()
 {
-	if (!IsConnected() || !LocalPlayerCharacter.IsValid())
+	if (!IsConnected())
+	{
+		return;
+	}
+
+	// Every tick, so the server's delta baselines keep up while our own state is idle
+	SendRemoteStateAcks();
+
+	if (!LocalPlayerCharacter.IsValid())
 	{
 		return;
 	}
 
 	FCombatNetworkState State = LocalPlayerCharacter->GetNetworkState();
+
+	if (GetDefault<UCombatNetworkSettings>()->bAdaptiveSendRate && !StateSendPolicy.ShouldSend(State, FPlatformTime::Seconds()))
+	{
+		++NetworkStats.StatesSkipped;
+		return;
+	}
+
 	SendPlayerState(State);
 }
 
-void UCombatNetworkSubsystem::SendAttack(const FString& TargetPlayerId)
+void UCombatNetworkSubsystem::SendAttack(const FString& TargetPlayerId, double RenderTime, FVector HitLocation)
 {
 	if (!IsConnected())
 	{
 		return;
 	}
 
-	TSharedPtr<FJsonObject> Data = MakeShareable(new FJsonObject());
-	Data->SetStringField(TEXT("target_id"), TargetPlayerId);
+	// The server knows the target by net id, if it assigned us one
+	FCombatJsonWriter& Writer = BeginMessage("attack");
+	const int32* TargetSlot = RemotePlayerSlotsById.Find(TargetPlayerId);
+	if (LocalNetId != CombatNetProtocol::InvalidNetId && TargetSlot)
+	{
+		Writer.Key("target_net_id");
+		Writer.Number(*TargetSlot);
+	}
+	else
+	{
+		Writer.Key("target_id");
+		Writer.String(TargetPlayerId);
+	}
 
-	SendMessage(TEXT("attack"), Data);
+	// Lets the server check the hit against where the target was on our screen, not where it is now
+	if (RenderTime > 0.0)
+	{
+		Writer.Key("render_time");
+		Writer.Number(RenderTime);
+		Writer.Key("hit_location");
+		Writer.Vector(HitLocation);
+	}
+	QueueMessage();
 	UE_LOG(LogCombatNetwork, Log, TEXT("Sent attack request for target: %s"), *TargetPlayerId);
 }
 
-void UCombatNetworkSubsystem::HandleDamage(const TSharedPtr<FJsonObject>& Data)
+void UCombatNetworkSubsystem::SendCombatEvent(ECombatEventType Type, int32 ComboStage)
 {
-	if (!Data.IsValid())
+	if (!IsConnected())
 	{
 		return;
 	}
 
-	FString AttackerId = Data->GetStringField(TEXT("attacker_id"));
-	FString TargetId = Data->GetStringField(TEXT("target_id"));
-	float Damage = Data->GetNumberField(TEXT("damage"));
-	float TargetHP = Data->GetNumberField(TEXT("target_hp"));
-	bool bTargetDead = Data->GetBoolField(TEXT("target_dead"));
+	FCombatJsonWriter& Writer = BeginMessage("combat_event");
+	Writer.Key("seq");
+	Writer.Number(static_cast<int32>(OutgoingCombatEventSequence++));
+	Writer.Key("event");
+	Writer.Number(static_cast<int32>(Type));
+	Writer.Key("combo_stage");
+	Writer.Number(ComboStage);
+
+	// Same timeline as our state timestamps, so receivers line the event up with our movement
+	if (ClockSync.IsSynchronized())
+	{
+		Writer.Key("time");
+		Writer.Number(GetServerTime());
+	}
+	QueueMessage();
+}
+
+void UCombatNetworkSubsystem::HandleDamage(const FCombatDamageMessage& Message)
+{
+	FString AttackerId(Message.AttackerId);
+	FString TargetId(Message.TargetId);
+	float Damage = Message.Damage;
+	float TargetHP = Message.TargetHP;
+	bool bTargetDead = Message.bTargetDead;
 
-	UE_LOG(LogCombatNetwork, Log, TEXT("Damage event: %s hit %s for %.0f damage (HP: %.0f, Dead: %s)"),
-		*AttackerId, *TargetId, Damage, TargetHP, bTargetDead ? TEXT("YES") : TEXT("NO"));
+	UE_LOG(LogCombatNetwork, Log, TEXT("Damage event: %s/%u hit %s/%u for %.0f damage (HP: %.0f, Dead: %s)"),
+		*AttackerId, Message.AttackerNetId, *TargetId, Message.TargetNetId, Damage, TargetHP, bTargetDead ? TEXT("YES") : TEXT("NO"));
 
 	// Is the target the local player?
-	if (TargetId == LocalPlayerId)
+	if (IsLocalPlayer(Message.TargetNetId, Message.TargetId))
 	{
 		if (LocalPlayerCharacter.IsValid())
 		{
@@ -613,10 +1381,10 @@ void UCombatNetworkSubsystem::HandleDamage(const TSharedPtr<FJsonObject>& Data)
 	else
 	{
 		// It's a remote player
-		ACombatRemotePlayer** FoundPlayer = RemotePlayers.Find(TargetId);
-		if (FoundPlayer && *FoundPlayer)
+		const int32 TargetSlot = FindRemotePlayerSlot(Message.TargetNetId, Message.TargetId);
+		if (TargetSlot != INDEX_NONE && RemotePlayerSlots[TargetSlot].Pawn)
 		{
-			ACombatRemotePlayer* RemotePlayer = *FoundPlayer;
+			ACombatRemotePlayer* RemotePlayer = RemotePlayerSlots[TargetSlot].Pawn;
 
 			// Update HP from server
 			RemotePlayer->SetCurrentHP(TargetHP);
@@ -633,19 +1401,20 @@ void UCombatNetworkSubsystem::HandleDamage(const TSharedPtr<FJsonObject>& Data)
 				FVector AttackerLocation = FVector::ZeroVector;
 
 				// Check if attacker is local player
-				if (AttackerId == LocalPlayerId && LocalPlayerCharacter.IsValid())
+				const int32 AttackerSlot = FindRemotePlayerSlot(Message.AttackerNetId, Message.AttackerId);
+				if (IsLocalPlayer(Message.AttackerNetId, Message.AttackerId) && LocalPlayerCharacter.IsValid())
 				{
 					AttackerLocation = LocalPlayerCharacter->GetActorLocation();
 					DamageDir = (RemotePlayer->GetActorLocation() - AttackerLocation).GetSafeNormal();
 				}
 				// Check if attacker is a remote player
-				else if (ACombatRemotePlayer** AttackerPlayer = RemotePlayers.Find(AttackerId))
+				else if (AttackerSlot != INDEX_NONE && RemotePlayerSlots[AttackerSlot].Pawn)
 				{
-					AttackerLocation = (*AttackerPlayer)->GetActorLocation();
+					AttackerLocation = RemotePlayerSlots[AttackerSlot].Pawn->GetActorLocation();
 					DamageDir = (RemotePlayer->GetActorLocation() - AttackerLocation).GetSafeNormal();
 				}
 
-				// Call ApplyDamage to trigger hit reaction (sets HitReactionTimer, knockback, BP event)
+				// Call ApplyDamage to trigger hit reaction (knockback, BP event)
 				FVector DamageImpulse = DamageDir * 500.0f;
 				RemotePlayer->ApplyDamage(Damage, nullptr, RemotePlayer->GetActorLocation(), DamageImpulse);
 			}
@@ -653,47 +1422,25 @@ void UCombatNetworkSubsystem::HandleDamage(const TSharedPtr<FJsonObject>& Data)
 	}
 }
 
-void UCombatNetworkSubsystem::HandleRespawn(const TSharedPtr<FJsonObject>& Data)
+void UCombatNetworkSubsystem::HandleRespawn(const FCombatRespawnMessage& Message)
 {
-	if (!Data.IsValid())
-	{
-		return;
-	}
-
-	FString PlayerId = Data->GetStringField(TEXT("player_id"));
-	float HP = Data->GetNumberField(TEXT("hp"));
-	float MaxHPValue = Data->GetNumberField(TEXT("max_hp"));
+	FString PlayerId(Message.PlayerId);
+	float HP = Message.HP;
 
 	// Get spawn position
 	FVector SpawnPosition = FVector::ZeroVector;
-	const TArray<TSharedPtr<FJsonValue>>* PosArray;
-	if (Data->TryGetArrayField(TEXT("position"), PosArray) && PosArray->Num() >= 2)
+	if (Message.bHasPosition)
 	{
-		SpawnPosition.X = (*PosArray)[0]->AsNumber();
-		SpawnPosition.Y = (*PosArray)[1]->AsNumber();
-
-		// Find ground Z
-		UWorld* World = GetWorld();
-		if (World)
-		{
-			FVector TraceStart(SpawnPosition.X, SpawnPosition.Y, 50000.0f);
-			FVector TraceEnd(SpawnPosition.X, SpawnPosition.Y, -50000.0f);
-
-			FHitResult HitResult;
-			FCollisionQueryParams QueryParams;
-
-			if (World->LineTraceSingleByChannel(HitResult, TraceStart, TraceEnd, ECC_WorldStatic, QueryParams))
-			{
-				SpawnPosition.Z = HitResult.Location.Z + 100.0f;
-			}
-		}
+		SpawnPosition.X = Message.Position.X;
+		SpawnPosition.Y = Message.Position.Y;
+		SpawnPosition.Z = FindSpawnHeight(SpawnPosition);
 	}
 
-	UE_LOG(LogCombatNetwork, Log, TEXT("Respawn event: %s at X=%.1f Y=%.1f Z=%.1f with HP=%.0f"),
-		*PlayerId, SpawnPosition.X, SpawnPosition.Y, SpawnPosition.Z, HP);
+	UE_LOG(LogCombatNetwork, Log, TEXT("Respawn event: %s/%u at X=%.1f Y=%.1f Z=%.1f with HP=%.0f"),
+		*PlayerId, Message.NetId, SpawnPosition.X, SpawnPosition.Y, SpawnPosition.Z, HP);
 
 	// Is this the local player?
-	if (PlayerId == LocalPlayerId)
+	if (IsLocalPlayer(Message.NetId, Message.PlayerId))
 	{
 		if (LocalPlayerCharacter.IsValid())
 		{
@@ -705,34 +1452,110 @@ void UCombatNetworkSubsystem::HandleRespawn(const TSharedPtr<FJsonObject>& Data)
 	else
 	{
 		// Remote player respawn
-		ACombatRemotePlayer** FoundPlayer = RemotePlayers.Find(PlayerId);
-		if (FoundPlayer && *FoundPlayer)
+		const int32 Slot = FindRemotePlayerSlot(Message.NetId, Message.PlayerId);
+		if (Slot == INDEX_NONE)
+		{
+			return;
+		}
+
+		FCombatRemotePlayerSlot& Entry = RemotePlayerSlots[Slot];
+		if (ACombatRemotePlayer* RemotePlayer = Entry.Pawn)
 		{
-			ACombatRemotePlayer* RemotePlayer = *FoundPlayer;
 			RemotePlayer->SetActorLocation(SpawnPosition);
 			RemotePlayer->SetCurrentHP(HP);
 			RemotePlayer->HandleRespawn();
 		}
+		else
+		{
+			// What was kept from before the respawn would spawn the pawn where it died
+			FCombatPendingRemotePlayer& Pending = Entry.Pending;
+			Pending.JoinPosition = SpawnPosition;
+			Pending.bJoinHeightKnown = true;
+			Pending.States.Reset();
+			Pending.Events.Reset();
+		}
 	}
 }
 
-void UCombatNetworkSubsystem::SendMessage(const FString& Type, const TSharedPtr<FJsonObject>& Data)
+FCombatJsonWriter& UCombatNetworkSubsystem::BeginMessage(const ANSICHAR* Type)
 {
-	if (!WebSocket.IsValid() || !WebSocket->IsConnected())
+	// The first message of a frame opens a batch envelope. If it stays the only one, it is sent
+	// without the envelope by skipping past it
+	if (NumOutboundMessages == 0)
+	{
+		OutboundWriter.Reset();
+		OutboundWriter.BeginObject();
+		OutboundWriter.Key("type");
+		OutboundWriter.String(UTF8TEXTVIEW("batch"));
+		OutboundWriter.Key("data");
+		OutboundWriter.BeginObject();
+		OutboundWriter.Key("messages");
+		OutboundWriter.BeginArray();
+		OutboundBatchHeaderSize = OutboundBuffer.Num();
+	}
+
+	OutboundWriter.BeginObject();
+	OutboundWriter.Key("type");
+	OutboundWriter.String(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Type)));
+	OutboundWriter.Key("data");
+	OutboundWriter.BeginObject();
+	return OutboundWriter;
+}
+
+void UCombatNetworkSubsystem::QueueMessage(bool bFlushImmediately)
+{
+	// Close "data" and the message
+	OutboundWriter.EndObject();
+	OutboundWriter.EndObject();
+	++NumOutboundMessages;
+
+	if (bFlushImmediately)
+	{
+		FlushOutboundMessages();
+	}
+}
+
+void UCombatNetworkSubsystem::OnEndFrame()
+{
+	// Actions ask for a state instead of waiting for the next network tick, up to a tick interval sooner
+	if (bStateSendRequested && IsConnected() && LocalPlayerCharacter.IsValid())
+	{
+		SendPlayerState(LocalPlayerCharacter->GetNetworkState());
+		++NetworkStats.StatesSentOnAction;
+	}
+	bStateSendRequested = false;
+
+	FlushOutboundMessages();
+}
+
+void UCombatNetworkSubsystem::FlushOutboundMessages()
+{
+	if (NumOutboundMessages == 0)
 	{
 		return;
 	}
 
-	TSharedPtr<FJsonObject> Message = MakeShareable(new FJsonObject());
-	Message->SetStringField(TEXT("type"), Type);
-	if (Data.IsValid())
+	const int32 NumMessages = NumOutboundMessages;
+	NumOutboundMessages = 0;
+
+	if (!WebSocket.IsValid() || !WebSocket->IsConnected())
 	{
-		Message->SetObjectField(TEXT("data"), Data);
+		return;
 	}
 
-	FString MessageString;
-	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&MessageString);
-	FJsonSerializer::Serialize(Message.ToSharedRef(), Writer);
+	if (NumMessages == 1)
+	{
+		WebSocket->Send(OutboundBuffer.GetData() + OutboundBatchHeaderSize, OutboundBuffer.Num() - OutboundBatchHeaderSize, false);
+	}
+	else
+	{
+		// Close "messages", "data" and the batch
+		OutboundWriter.EndArray();
+		OutboundWriter.EndObject();
+		OutboundWriter.EndObject();
+		WebSocket->Send(OutboundBuffer.GetData(), OutboundBuffer.Num(), false);
+	}
 
-	WebSocket->Send(MessageString);
+	NetworkStats.MessagesSent += NumMessages;
+	++NetworkStats.MessageFramesSent;
 }
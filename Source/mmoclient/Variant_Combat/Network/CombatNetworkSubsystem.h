@@ -4,12 +4,24 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
 #include "CombatNetworkTypes.h"
+#include "CombatNetworkProtocol.h"
+#include "CombatNetworkMessages.h"
+#include "CombatNetworkDispatch.h"
+#include "CombatNetworkInbound.h"
+#include "CombatNetworkJson.h"
+#include "CombatNetworkSendPolicy.h"
+#include "CombatNetworkClock.h"
+#include "CombatNetworkJitter.h"
+#include "CombatNetworkRelevance.h"
 #include "IWebSocket.h"
 #include "CombatNetworkSubsystem.generated.h"
 
 class ACombatRemotePlayer;
+class UCombatRemotePlayerPool;
 class ACombatCharacter;
+class UCombatPredictedMovementComponent;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogCombatNetwork, Log, All);
 
@@ -70,18 +82,104 @@ public:
 	UFUNCTION(BlueprintPure, Category="Network")
 	FString GetLocalPlayerId() const { return LocalPlayerId; }
 
+	/**
+	 * Get the local player's net id, or InvalidNetId if the server doesn't assign them
+	 */
+	uint32 GetLocalNetId() const { return LocalNetId; }
+
+	/**
+	 * Find a remote player's pawn by the server's player ID
+	 * @return The pawn, or null if the player isn't in the zone or has no pawn right now
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	ACombatRemotePlayer* FindRemotePlayer(const FString& PlayerId) const;
+
+	/**
+	 * Get the wire protocol agreed with the server in the join handshake
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	ECombatWireProtocol GetActiveProtocol() const { return ActiveProtocol; }
+
+	/**
+	 * Get counters describing traffic since the last Connect
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	FCombatNetworkStats GetNetworkStats() const { return NetworkStats; }
+
+	/**
+	 * Get the current server time in seconds, the timeline that state timestamps are on.
+	 * Equal to the local clock until the first clock probe is answered
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	double GetServerTime() const { return ClockSync.GetServerTime(FPlatformTime::Seconds()); }
+
+	/**
+	 * Get the round trip time to the server in seconds, the median of recent clock probes
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	double GetRTT() const { return ClockSync.GetRoundTripTime(); }
+
+	/**
+	 * Get how much the round trip time varies, in seconds
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	double GetJitter() const { return ClockSync.GetJitter(); }
+
+	/**
+	 * Check whether GetServerTime is based on at least one answered clock probe
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	bool IsClockSynchronized() const { return ClockSync.IsSynchronized(); }
+
+	/**
+	 * Get how far behind the server remote players are rendered, in seconds.
+	 * Adapts to how regularly states arrive, within the bounds in the project settings
+	 */
+	UFUNCTION(BlueprintPure, Category="Network")
+	double GetInterpolationDelay() const { return JitterBuffer.GetDelay(); }
+
+	/** Add how remote player interpolation fared this frame to the network stats */
+	void RecordInterpolationStats(int32 Underruns, double ExtrapolationTime);
+
+	/**
+	 * Send every JSON message queued so far in this frame. Runs by itself at the end of every frame.
+	 * A single message is sent as-is; several are packed into one frame as
+	 * {"type":"batch","data":{"messages":[...]}} and must be handled by the server in order
+	 */
+	void FlushOutboundMessages();
+
 	/**
 	 * Send the local player's state to the server
 	 */
 	UFUNCTION(BlueprintCallable, Category="Network")
 	void SendPlayerState(const FCombatNetworkState& State);
 
+	/**
+	 * Send the local player's state at the end of this frame, whatever the send policy says, e.g. right
+	 * after a discrete action. It goes out with the frame's other messages and leaves the network
+	 * tick's cadence alone. Several requests in one frame send one state
+	 */
+	UFUNCTION(BlueprintCallable, Category="Network")
+	void RequestStateSend() { bStateSendRequested = true; }
+
 	/**
 	 * Send an attack request to the server (server validates and applies damage)
 	 * @param TargetPlayerId The ID of the player being attacked
+	 * @param RenderTime Server time the target was drawn at when it was hit, so the server can rewind it. 0 if unknown
+	 * @param HitLocation Where the attack hit the target
 	 */
 	UFUNCTION(BlueprintCallable, Category="Network")
-	void SendAttack(const FString& TargetPlayerId);
+	void SendAttack(const FString& TargetPlayerId, double RenderTime = 0.0, FVector HitLocation = FVector::ZeroVector);
+
+	/**
+	 * Send a discrete combat action of the local player. Events are numbered and stamped with the
+	 * server time they happened at, so remote clients play every one of them, in order, in step with
+	 * the player's movement
+	 * @param Type What happened
+	 * @param ComboStage Combo section the event refers to
+	 */
+	UFUNCTION(BlueprintCallable, Category="Network")
+	void SendCombatEvent(ECombatEventType Type, int32 ComboStage = 0);
 
 	/**
 	 * Set the class to spawn for remote players
@@ -96,7 +194,8 @@ public:
 	void SetLocalPlayerCharacter(ACombatCharacter* InCharacter);
 
 	/**
-	 * Start sending network updates at the specified rate
+	 * Start sending network updates at the specified rate. With an adaptive send rate, this is how
+	 * often the local state is checked, and ticks it hasn't changed enough on send nothing
 	 * @param TickRate Updates per second (default 20Hz)
 	 */
 	UFUNCTION(BlueprintCallable, Category="Network")
@@ -108,6 +207,19 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Network")
 	void StopNetworkTick();
 
+	/**
+	 * Register a handler for a server message type, so gameplay code can add messages without touching the subsystem.
+	 * Types registered before Connect are included in the opcode table sent to the server in the join handshake.
+	 * @param Type Wire type name, e.g. "loot_drop"
+	 * @return The type's opcode, or INDEX_NONE if the type already has a handler
+	 */
+	int32 RegisterMessageHandler(FUtf8StringView Type, FCombatNetworkMessageHandler Handler);
+
+	/**
+	 * Remove a handler added with RegisterMessageHandler
+	 */
+	void UnregisterMessageHandler(int32 Opcode);
+
 public:
 
 	/** Called when connection state changes */
@@ -128,28 +240,130 @@ protected:
 	void OnConnected();
 	void OnConnectionError(const FString& Error);
 	void OnClosed(int32 StatusCode, const FString& Reason, bool bWasClean);
-	void OnMessage(const FString& Message);
+	void OnRawMessage(const void* Data, SIZE_T Size, SIZE_T BytesRemaining);
+	void OnBinaryMessage(const void* Data, SIZE_T Size, bool bIsLastFragment);
+
+	/** Drain decoded inbound messages before actors tick */
+	void OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/** Send a requested state, then everything queued this frame */
+	void OnEndFrame();
+
+	/** Dispatch decoded messages in arrival order until the queue is empty or the frame's budget is spent */
+	void DrainInboundMessages();
+
+	/** Record the newest state timestamp per player across all pending frames */
+	void IndexPendingStates();
+
+	/** Return all pending frames to the pool without handling them */
+	void DiscardPendingInboundFrames();
+
+	/** Bind the subsystem's own message handlers to their wire types */
+	void RegisterBuiltinMessageHandlers();
 
-	/** Message handlers */
-	void HandleJoinResponse(const TSharedPtr<FJsonObject>& Data);
-	void HandlePlayerJoined(const TSharedPtr<FJsonObject>& Data);
-	void HandlePlayerState(const TSharedPtr<FJsonObject>& Data);
-	void HandlePlayerLeft(const TSharedPtr<FJsonObject>& Data);
-	void HandlePositionCorrection(const TSharedPtr<FJsonObject>& Data);
-	void HandleDamage(const TSharedPtr<FJsonObject>& Data);
-	void HandleRespawn(const TSharedPtr<FJsonObject>& Data);
+	/** Bind Type to a worker-side Decode into MessageType, and a game thread Handle of the result. Returns the type's opcode */
+	template <auto Decode, typename MessageType>
+	int32 RegisterBuiltinMessageHandler(const ANSICHAR* Type, void (UCombatNetworkSubsystem::*Handle)(const MessageType&))
+	{
+		return MessageDispatcher.RegisterDecodedHandler(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Type)),
+			[](FUtf8StringView Data, FCombatInboundMessage& OutMessage)
+			{
+				return Decode(Data, OutMessage.Emplace<MessageType>(), OutMessage.Strings);
+			},
+			FCombatInboundMessageHandler::CreateWeakLambda(this, [this, Handle](const FCombatInboundMessage& Message)
+			{
+				(this->*Handle)(Message.Get<MessageType>());
+			}));
+	}
 
-	/** Spawn a remote player pawn */
-	ACombatRemotePlayer* SpawnRemotePlayer(const FString& PlayerId, const FVector& Position);
+	/** Message handlers, shared by the JSON and binary decoders */
+	void HandleJoinResponse(const FCombatJoinResponseMessage& Message);
+	void HandlePlayerJoined(const FCombatPlayerJoinedMessage& Message);
+	void HandlePlayerState(const FCombatPlayerStateMessage& Message);
+	void HandlePlayerLeft(const FCombatPlayerLeftMessage& Message);
+	void HandlePositionCorrection(const FCombatPositionCorrectionMessage& Message);
+	void HandleDamage(const FCombatDamageMessage& Message);
+	void HandleRespawn(const FCombatRespawnMessage& Message);
+	void HandleStateAck(const FCombatStateAckMessage& Message);
+	void HandleCombatEvent(const FCombatEventMessage& Message);
 
-	/** Destroy a remote player pawn */
-	void DestroyRemotePlayer(const FString& PlayerId);
+	/** Feed the answer to a clock probe, received at ReceiveTime, to the clock estimate */
+	void HandlePong(const FCombatPongMessage& Message, double ReceiveTime);
+
+	/** Send a clock probe if one is due */
+	void ProbeServerClock();
+
+	/** Feed a received state frame, sampled at Timestamp and received at ReceiveTime, to the jitter buffer */
+	void AddStateArrival(double Timestamp, double ReceiveTime);
+
+	/** Apply every state in a world_snapshot in one pass */
+	void HandleWorldSnapshot(const FCombatWorldSnapshot& Snapshot);
+
+	/** Send the local state as a delta against the newest state the server acknowledged */
+	void SendPlayerStateDelta(const FCombatNetworkState& State, int32 InputSequence);
+
+	/** Acknowledge the newest delta of every remote player that sent one since the last tick */
+	void SendRemoteStateAcks();
+
+	/** The local character's movement component, if it predicts movement */
+	UCombatPredictedMovementComponent* GetLocalPredictedMovement() const;
+
+	/** Reset everything negotiated or accumulated for the current connection */
+	void ResetProtocolState();
+
+	/** Show a remote player with a pawn from the pool, or a newly spawned one if the pool is empty */
+	ACombatRemotePlayer* SpawnRemotePlayer(int32 Slot, const FVector& Position);
+
+	/** Whether players can be looked up by NetId: it's set, and the server assigned net ids in the join handshake */
+	bool HasNetId(uint32 NetId) const { return NetId != CombatNetProtocol::InvalidNetId && LocalNetId != CombatNetProtocol::InvalidNetId; }
+
+	/** Whether a message naming NetId or PlayerId is about the local player */
+	bool IsLocalPlayer(uint32 NetId, FUtf8StringView PlayerId) const;
+
+	/** Slot of the remote player a message names, by net id if it has one, or INDEX_NONE if the player isn't known */
+	int32 FindRemotePlayerSlot(uint32 NetId, FUtf8StringView PlayerId) const;
+
+	/** Slot of the remote player a message names, added if the player isn't known. INDEX_NONE for the local player */
+	int32 FindOrAddRemotePlayerSlot(uint32 NetId, FUtf8StringView PlayerId);
+
+	/** Measure relevance from the local player and its camera this frame */
+	void UpdateRelevanceViewer();
+
+	/** Release the pawns of remote players that stopped being relevant, keeping the players as data */
+	void DematerializeIrrelevantRemotePlayers();
+
+	/** Spawn relevant waiting remote players, nearest first, until the frame's spawn budget is spent */
+	void SpawnPendingRemotePlayers();
+
+	/** Spawn one waiting remote player and catch its pawn up with what was received while it waited. Returns whether it spawned */
+	bool SpawnPendingRemotePlayer(int32 Slot);
+
+	/** Height of the ground under Position, plus clearance for a capsule, or Position's own height if there's no ground */
+	double FindSpawnHeight(const FVector& Position) const;
+
+	/** Height of the level's ground under Position, from the world's ground height grid. Returns false if there's no ground */
+	bool FindGroundHeight(const FVector& Position, double& OutGroundZ) const;
+
+	/** Return a remote player's pawn to the pool and free its slot */
+	void ReleaseRemotePlayer(int32 Slot);
+
+	/** Return every remote player's pawn to the pool */
+	void ReleaseAllRemotePlayers();
+
+	/** Pool of remote player pawns in the current world */
+	UCombatRemotePlayerPool* GetRemotePlayerPool() const;
 
 	/** Network tick callback */
 	void NetworkTick();
 
-	/** Send a JSON message to the server */
-	void SendMessage(const FString& Type, const TSharedPtr<FJsonObject>& Data);
+	/** Start a JSON message of the given type in the outbound batch. Write its data fields with the returned writer, then call QueueMessage */
+	FCombatJsonWriter& BeginMessage(const ANSICHAR* Type);
+
+	/**
+	 * Close the message started by BeginMessage. It is sent at the end of the frame together with
+	 * every other message queued in the frame, or right away, with them, if bFlushImmediately is set
+	 */
+	void QueueMessage(bool bFlushImmediately = false);
 
 private:
 
@@ -159,9 +373,24 @@ private:
 	/** Local player's ID assigned by the server */
 	FString LocalPlayerId;
 
-	/** Map of remote player IDs to their pawn actors */
+	/** Local player's net id, or InvalidNetId if the server doesn't assign them */
+	uint32 LocalNetId = CombatNetProtocol::InvalidNetId;
+
+	/**
+	 * Remote players in the zone, with or without a pawn, indexed by net id. Servers that don't
+	 * assign net ids get slots picked by the client instead, looked up by string id
+	 */
 	UPROPERTY()
-	TMap<FString, ACombatRemotePlayer*> RemotePlayers;
+	TArray<FCombatRemotePlayerSlot> RemotePlayerSlots;
+
+	/** Slot of every named remote player by string id, for Blueprint and for servers without net ids */
+	TMap<FString, int32> RemotePlayerSlotsById;
+
+	/** Slots freed by players that left, reused when the server doesn't assign net ids */
+	TArray<int32> FreeRemotePlayerSlots;
+
+	/** Order given to the next remote player added */
+	uint32 NextPendingRemotePlayerOrder = 0;
 
 	/** Class to spawn for remote players */
 	UPROPERTY()
@@ -176,4 +405,91 @@ private:
 
 	/** Whether we're currently connected */
 	bool bIsConnected = false;
+
+	/** Wire protocol agreed with the server. JSON until join_response says otherwise */
+	ECombatWireProtocol ActiveProtocol = ECombatWireProtocol::Json;
+
+	/** Interned server message types and their handlers */
+	FCombatMessageDispatcher MessageDispatcher;
+
+	/** Decodes received frames on a worker and queues them for DrainInboundMessages */
+	TUniquePtr<FCombatInboundPipeline> InboundPipeline;
+
+	/** Registration of OnWorldPreActorTick */
+	FDelegateHandle PreActorTickHandle;
+
+	/** Registration of FlushOutboundMessages with the end of the frame */
+	FDelegateHandle EndFrameHandle;
+
+	/** Opcodes of the messages that carry remote player states */
+	int32 PlayerStateOpcode = INDEX_NONE;
+	int32 WorldSnapshotOpcode = INDEX_NONE;
+
+	/** Decoded frames not yet handled, oldest first. Frames that didn't fit a frame's budget wait here */
+	TArray<FCombatInboundFrame*> PendingInboundFrames;
+
+	/** The pending frames while DrainInboundMessages dispatches them, out of reach of a disconnect. Reused across frames */
+	TArray<FCombatInboundFrame*> DrainingInboundFrames;
+
+	/**
+	 * Newest state timestamp per player among PendingInboundFrames, while they are being drained, by
+	 * net id or, for players named by string id, by string. String keys point into those frames
+	 */
+	TMap<uint32, double> NewestPendingStateTimesByNetId;
+	TMap<FUtf8StringView, double, FDefaultSetAllocator, TCombatPlayerIdKeyFuncs<double>> NewestPendingStateTimes;
+
+	/** Traffic counters */
+	FCombatNetworkStats NetworkStats;
+
+	/** Reassembly buffer for fragmented inbound text frames, reused across frames */
+	TArray<uint8> TextReceiveBuffer;
+
+	/** Reassembly buffer for fragmented inbound binary frames, reused across frames */
+	TArray<uint8> BinaryReceiveBuffer;
+
+	/** JSON messages queued this frame, inside a batch envelope that is left out if only one is sent. Reused across frames */
+	TArray<uint8> OutboundBuffer;
+	FCombatJsonWriter OutboundWriter { OutboundBuffer };
+
+	/** Size of the batch envelope's opening at the start of OutboundBuffer */
+	int32 OutboundBatchHeaderSize = 0;
+
+	/** Messages in OutboundBuffer */
+	int32 NumOutboundMessages = 0;
+
+	/** Whether the local state should be sent at the end of this frame. Cleared by any state send */
+	bool bStateSendRequested = false;
+
+	/** Scratch buffer for outbound binary frames, reused across sends */
+	TArray<uint8> BinarySendBuffer;
+
+	/** Origin that delta-protocol positions are quantized against, from join_response */
+	FVector ZoneOrigin = FVector::ZeroVector;
+
+	/** Sequence number of the next StateDelta we send */
+	uint16 OutgoingStateSequence = 0;
+
+	/** Sequence number of the next combat event we send */
+	uint16 OutgoingCombatEventSequence = 0;
+
+	/** Newest StateDelta sequence the server acknowledged, or INDEX_NONE */
+	int32 LastAckedOutgoingSequence = INDEX_NONE;
+
+	/** Scratch list of remote player deltas to acknowledge, reused across ticks */
+	TArray<FCombatRemoteStateAck> OutgoingStateAcks;
+
+	/** Decides which network ticks send the local state */
+	FCombatStateSendPolicy StateSendPolicy;
+
+	/** Server clock estimate */
+	FCombatClockSync ClockSync;
+
+	/** Chooses the interpolation delay from how state frames arrive */
+	FCombatJitterBuffer JitterBuffer;
+
+	/** Decides which remote players get a pawn */
+	FCombatRelevanceFilter RelevanceFilter;
+
+	/** Quantized states we sent, kept until they're too old to be used as a baseline */
+	FCombatStateHistory SentStateHistory;
 };
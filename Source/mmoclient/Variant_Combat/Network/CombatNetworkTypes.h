@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "CombatNetworkTypes.generated.h"
 
+class ACombatRemotePlayer;
+
 /**
  * Animation states that can be synchronized over the network
  */
@@ -21,6 +23,37 @@ enum class ECombatAnimationState : uint8
 	Dead
 };
 
+/**
+ * Discrete combat actions, sent as they happen rather than sampled with the state
+ */
+UENUM(BlueprintType)
+enum class ECombatEventType : uint8
+{
+	/** First swing of a combo */
+	AttackStart,
+	/** Combo continued into the next section; ComboStage is the new section */
+	ComboAdvance,
+	/** Charged attack started charging */
+	ChargeStart,
+	/** Charged attack released */
+	ChargeRelease,
+	/** The player was hit */
+	Hit,
+	/** The player died */
+	Death
+};
+
+/**
+ * Wire encodings the client can negotiate with the server during the join handshake
+ */
+UENUM(BlueprintType)
+enum class ECombatWireProtocol : uint8
+{
+	Json,
+	Binary,
+	BinaryDelta
+};
+
 /**
  * Network-syncable state for combat characters
  */
@@ -65,3 +98,155 @@ struct FCombatNetworkState
 	UPROPERTY(BlueprintReadWrite, Category="Network")
 	double Timestamp = 0.0;
 };
+
+/**
+ * A combat event of a remote player, waiting to be played back on its interpolation timeline
+ */
+struct FCombatEvent
+{
+	ECombatEventType Type = ECombatEventType::AttackStart;
+
+	/** Combo section the event refers to */
+	int32 ComboStage = 0;
+
+	/** Per-sender sequence, wrapping at 16 bits */
+	uint16 Sequence = 0;
+
+	/** Server time the sender performed the action, or 0 if it had no synchronized clock */
+	double Timestamp = 0.0;
+
+	/** Local time the event was received */
+	double ReceiveTime = 0.0;
+};
+
+/**
+ * A remote player known to be in the zone but without a pawn, because it hasn't spawned yet or
+ * isn't relevant to the local player. Collects what the server sends about the player until it
+ * gets a pawn, which is then caught up with it
+ */
+struct FCombatPendingRemotePlayer
+{
+	/** Where to spawn the pawn if no state arrives first */
+	FVector JoinPosition = FVector::ZeroVector;
+
+	/** Whether JoinPosition's height is known, or still has to be found with a ground trace */
+	bool bJoinHeightKnown = false;
+
+	/** Newest states received, oldest first */
+	TArray<FCombatNetworkState> States;
+
+	/** Combat events received, in arrival order */
+	TArray<FCombatEvent> Events;
+
+	/** Order the player was first heard of in, to break ties between equally near players */
+	uint32 Order = 0;
+
+	/** Whether the player has had a pawn, so its join has been announced already */
+	bool bJoinAnnounced = false;
+
+	/** Where the player is now, as far as we know */
+	FVector GetPosition() const { return States.Num() > 0 ? States.Last().Position : JoinPosition; }
+};
+
+/**
+ * A remote player in the zone, as stored by the network subsystem in an array indexed by the player's net id
+ */
+USTRUCT()
+struct FCombatRemotePlayerSlot
+{
+	GENERATED_BODY()
+
+	/** The server's string id, for logs, delegates and Blueprint. Empty until a message names the player */
+	FString PlayerId;
+
+	/** The player's pawn, or null while it's kept only as data */
+	UPROPERTY(Transient)
+	TObjectPtr<ACombatRemotePlayer> Pawn;
+
+	/** What's known about the player while it has no pawn */
+	FCombatPendingRemotePlayer Pending;
+
+	/** Whether a player occupies the slot */
+	bool bInUse = false;
+};
+
+/**
+ * Counters describing the network client's traffic since the last Connect
+ */
+USTRUCT(BlueprintType)
+struct FCombatNetworkStats
+{
+	GENERATED_BODY()
+
+	/** Remote player states applied to their pawns */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 StatesApplied = 0;
+
+	/** Remote player states skipped because a newer state for the same player was queued in the same frame */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 RedundantStatesDropped = 0;
+
+	/** Local player states sent to the server */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 StatesSent = 0;
+
+	/** Network ticks that sent nothing because remote clients could still extrapolate the last sent state */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 StatesSkipped = 0;
+
+	/** Local player states sent right after an action instead of on a network tick. Included in StatesSent */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 StatesSentOnAction = 0;
+
+	/** JSON messages sent to the server */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 MessagesSent = 0;
+
+	/** WebSocket text frames those messages were packed into */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 MessageFramesSent = 0;
+
+	/** How far behind the server remote players are currently rendered, in seconds */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	float InterpolationDelay = 0.0f;
+
+	/** Mean time between received state frames, in seconds */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	float InterArrivalMean = 0.0f;
+
+	/** Standard deviation of the time between state frames around the spacing they were sent at, in seconds */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	float InterArrivalDeviation = 0.0f;
+
+	/** Smoothed share of states that arrived after the moment they describe had been rendered */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	float LateStateRatio = 0.0f;
+
+	/** Times a remote player ran out of received states and started extrapolating */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 InterpolationUnderruns = 0;
+
+	/** Time remote players spent extrapolating, summed over all of them, in seconds */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	float ExtrapolationTime = 0.0f;
+
+	/** Remote players shown with a pawn taken from the pool */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 RemotePlayerPoolHits = 0;
+
+	/** Remote players that had to spawn a pawn because the pool was empty */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 RemotePlayerPoolMisses = 0;
+
+	/** Remote players in the zone with a pawn */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 RemotePlayerPawns = 0;
+
+	/** Remote players in the zone kept only as data, waiting to spawn or not relevant */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 DataOnlyRemotePlayers = 0;
+
+	/** Pawns released because their players stopped being relevant */
+	UPROPERTY(BlueprintReadOnly, Category="Network")
+	int32 RemotePlayersDematerialized = 0;
+};
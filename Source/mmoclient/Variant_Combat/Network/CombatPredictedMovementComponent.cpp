@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatPredictedMovementComponent.h"
+#include "CombatNetworkProtocol.h"
+#include "GameFramework/Character.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void FCombatJumpState::Save(const ACharacter& Character)
+{
+	bPressedJump = Character.bPressedJump;
+	bWasJumping = Character.bWasJumping;
+	JumpCurrentCount = Character.JumpCurrentCount;
+	JumpCurrentCountPreJump = Character.JumpCurrentCountPreJump;
+	JumpKeyHoldTime = Character.JumpKeyHoldTime;
+	JumpForceTimeRemaining = Character.JumpForceTimeRemaining;
+}
+
+void FCombatJumpState::Restore(ACharacter& Character) const
+{
+	Character.bPressedJump = bPressedJump;
+	Character.bWasJumping = bWasJumping;
+	Character.JumpCurrentCount = JumpCurrentCount;
+	Character.JumpCurrentCountPreJump = JumpCurrentCountPreJump;
+	Character.JumpKeyHoldTime = JumpKeyHoldTime;
+	Character.JumpForceTimeRemaining = JumpForceTimeRemaining;
+}
+
+void UCombatPredictedMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!VisualError.IsZero())
+	{
+		VisualError *= FMath::Exp(-VisualErrorDecaySpeed * DeltaTime);
+		if (VisualError.SizeSquared() < FMath::Square(0.1f))
+		{
+			VisualError = FVector::ZeroVector;
+		}
+		ApplyVisualError();
+	}
+}
+
+int32 UCombatPredictedMovementComponent::GetLastInputSequence() const
+{
+	return bHasRecorded ? static_cast<uint16>(NextSequence - 1) : INDEX_NONE;
+}
+
+void UCombatPredictedMovementComponent::ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds)
+{
+	FCombatJumpState JumpState;
+	if (CharacterOwner)
+	{
+		JumpState.Save(*CharacterOwner);
+	}
+
+	Super::ControlledCharacterMove(InputVector, DeltaSeconds);
+
+	// Only the local player is predicted; AI-driven characters have nothing to reconcile
+	if (!CharacterOwner || !CharacterOwner->IsPlayerControlled())
+	{
+		return;
+	}
+
+	if (NumCommands == MaxCommands)
+	{
+		FirstCommand = (FirstCommand + 1) % MaxCommands;
+		--NumCommands;
+	}
+
+	FCombatInputCommand& Command = Commands[(FirstCommand + NumCommands) % MaxCommands];
+	Command.Sequence = NextSequence++;
+	Command.DeltaTime = DeltaSeconds;
+	Command.Acceleration = Acceleration;
+	Command.JumpState = JumpState;
+
+	++NumCommands;
+	bHasRecorded = true;
+}
+
+void UCombatPredictedMovementComponent::Reconcile(const FVector& Position, const FVector* InVelocity, int32 AckedSequence)
+{
+	if (!CharacterOwner || !UpdatedComponent)
+	{
+		return;
+	}
+
+	// Commands the server has processed are already part of Position
+	if (AckedSequence == INDEX_NONE)
+	{
+		NumCommands = 0;
+	}
+	else
+	{
+		while (NumCommands > 0 && !CombatNetProtocol::IsSequenceNewer(Commands[FirstCommand].Sequence, static_cast<uint16>(AckedSequence)))
+		{
+			FirstCommand = (FirstCommand + 1) % MaxCommands;
+			--NumCommands;
+		}
+	}
+
+	const FVector VisualLocation = UpdatedComponent->GetComponentLocation() + VisualError;
+
+	CharacterOwner->SetActorLocation(Position, false, nullptr, ETeleportType::TeleportPhysics);
+	if (InVelocity)
+	{
+		Velocity = *InVelocity;
+	}
+
+	// Root motion would advance the montage while replaying; take the server's position as is
+	if (!CharacterOwner->IsPlayingRootMotion() && NumCommands > 0)
+	{
+		// Replay from the jump state the first command started with, and return to the live one after
+		FCombatJumpState LiveJumpState;
+		LiveJumpState.Save(*CharacterOwner);
+		Commands[FirstCommand].JumpState.Restore(*CharacterOwner);
+
+		// Like the engine's own move replay, flag it so OnJumped can tell a replay from a real jump
+		const bool bWasClientUpdating = CharacterOwner->bClientUpdating;
+		CharacterOwner->bClientUpdating = true;
+		bReplaying = true;
+
+		for (int32 Index = 0; Index < NumCommands; ++Index)
+		{
+			ReplayCommand(Commands[(FirstCommand + Index) % MaxCommands]);
+		}
+
+		bReplaying = false;
+		CharacterOwner->bClientUpdating = bWasClientUpdating;
+		LiveJumpState.Restore(*CharacterOwner);
+	}
+
+	// Whatever the replay didn't agree on is hidden on the mesh and decays away
+	VisualError = VisualLocation - UpdatedComponent->GetComponentLocation();
+	if (VisualError.SizeSquared() > FMath::Square(MaxSmoothedError))
+	{
+		VisualError = FVector::ZeroVector;
+	}
+	ApplyVisualError();
+}
+
+void UCombatPredictedMovementComponent::ResetPrediction()
+{
+	FirstCommand = 0;
+	NumCommands = 0;
+	NextSequence = 0;
+	bHasRecorded = false;
+
+	VisualError = FVector::ZeroVector;
+	ApplyVisualError();
+}
+
+void UCombatPredictedMovementComponent::ReplayCommand(const FCombatInputCommand& Command)
+{
+	// Mirrors ControlledCharacterMove with the recorded input instead of the live one
+	CharacterOwner->bPressedJump = Command.JumpState.bPressedJump;
+	CharacterOwner->CheckJumpInput(Command.DeltaTime);
+
+	Acceleration = Command.Acceleration;
+	AnalogInputModifier = ComputeAnalogInputModifier();
+
+	PerformMovement(Command.DeltaTime);
+
+	CharacterOwner->ClearJumpInput(Command.DeltaTime);
+}
+
+void UCombatPredictedMovementComponent::ApplyVisualError()
+{
+	USkeletalMeshComponent* Mesh = CharacterOwner ? CharacterOwner->GetMesh() : nullptr;
+	if (!Mesh || !UpdatedComponent || Mesh->IsSimulatingPhysics())
+	{
+		return;
+	}
+
+	const FVector LocalError = UpdatedComponent->GetComponentTransform().InverseTransformVectorNoScale(VisualError);
+	Mesh->SetRelativeLocation(CharacterOwner->GetBaseTranslationOffset() + LocalError);
+}
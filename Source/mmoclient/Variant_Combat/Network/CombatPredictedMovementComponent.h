@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "CombatPredictedMovementComponent.generated.h"
+
+class ACharacter;
+
+/**
+ * The character's jump input and progress. Replaying a jump advances it, so it is put back afterwards
+ */
+struct FCombatJumpState
+{
+	bool bPressedJump = false;
+	bool bWasJumping = false;
+	int32 JumpCurrentCount = 0;
+	int32 JumpCurrentCountPreJump = 0;
+	float JumpKeyHoldTime = 0.0f;
+	float JumpForceTimeRemaining = 0.0f;
+
+	void Save(const ACharacter& Character);
+	void Restore(ACharacter& Character) const;
+};
+
+/**
+ * One frame of local movement, kept until the server has processed it
+ */
+struct FCombatInputCommand
+{
+	/** Wraps at 16 bits, like every other sequence on the wire */
+	uint16 Sequence = 0;
+
+	float DeltaTime = 0.0f;
+
+	/** Acceleration the movement component derived from the input this frame */
+	FVector Acceleration = FVector::ZeroVector;
+
+	/** Jump input and progress going into the frame */
+	FCombatJumpState JumpState;
+};
+
+/**
+ * Character movement that predicts the local player and reconciles it with the server.
+ *
+ * Every locally controlled move is numbered and recorded. The newest number goes out with each
+ * state update, and the server echoes the newest one it processed when it corrects our position.
+ * Reconcile then moves the character to the corrected position, drops the commands the server
+ * already accounted for and re-simulates the rest, so only the difference the server actually
+ * disagreed with remains. That difference is hidden by offsetting the mesh and letting the offset
+ * decay, rather than moving the capsule.
+ */
+UCLASS()
+class UCombatPredictedMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Sequence of the newest recorded command, or INDEX_NONE before the first one */
+	int32 GetLastInputSequence() const;
+
+	/**
+	 * Moves the character to the position the server computed after processing AckedSequence and re-simulates the newer commands.
+	 * @param Position authoritative capsule location
+	 * @param Velocity authoritative velocity, or null to keep the current one
+	 * @param AckedSequence newest command the server processed, or INDEX_NONE if unknown, in which case nothing is replayed
+	 */
+	void Reconcile(const FVector& Position, const FVector* Velocity, int32 AckedSequence);
+
+	/** Forgets every recorded command and any visual error being smoothed */
+	void ResetPrediction();
+
+	/** Whether recorded commands are being re-simulated. Jumps and landings seen meanwhile already happened once and shouldn't play effects again */
+	UFUNCTION(BlueprintPure, Category="Network Prediction")
+	bool IsReplaying() const { return bReplaying; }
+
+protected:
+
+	virtual void ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds) override;
+
+	/** Runs one recorded command through the movement simulation again */
+	void ReplayCommand(const FCombatInputCommand& Command);
+
+	/** Offsets the mesh by the remaining visual error */
+	void ApplyVisualError();
+
+	/** Corrections that move the character further than this are not smoothed */
+	UPROPERTY(EditAnywhere, Category="Network Prediction", meta=(ClampMin=0, Units="cm"))
+	float MaxSmoothedError = 200.0f;
+
+	/** How quickly the visual error decays, per second */
+	UPROPERTY(EditAnywhere, Category="Network Prediction", meta=(ClampMin=0))
+	float VisualErrorDecaySpeed = 10.0f;
+
+private:
+
+	static constexpr int32 MaxCommands = 128;
+
+	/** Ring of recorded commands, oldest at FirstCommand */
+	FCombatInputCommand Commands[MaxCommands];
+	int32 FirstCommand = 0;
+	int32 NumCommands = 0;
+
+	/** Sequence of the next recorded command */
+	uint16 NextSequence = 0;
+
+	/** Whether any command has been recorded since the last reset */
+	bool bHasRecorded = false;
+
+	/** Set while Reconcile re-simulates recorded commands */
+	bool bReplaying = false;
+
+	/** Where the mesh is drawn relative to where the capsule is, in world space */
+	FVector VisualError = FVector::ZeroVector;
+};
@@ -0,0 +1,113 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatProxyMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+
+UCombatProxyMovementComponent::UCombatProxyMovementComponent()
+{
+	// Moved by the owner; the component itself never simulates
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UCombatProxyMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetComponentTickEnabled(false);
+}
+
+void UCombatProxyMovementComponent::ResetKinematicState()
+{
+	KnockbackVelocity = FVector::ZeroVector;
+	KnockbackOffset = FVector::ZeroVector;
+	Velocity = FVector::ZeroVector;
+	Acceleration = FVector::ZeroVector;
+	bHasGroundProbe = false;
+}
+
+void UCombatProxyMovementComponent::AddImpulse(FVector Impulse, bool bVelocityChange)
+{
+	const float Mass = bVelocityChange ? 1.0f : FMath::Max(UE_KINDA_SMALL_NUMBER, GetMass());
+	KnockbackVelocity += FVector(Impulse.X, Impulse.Y, 0.0f) / Mass;
+}
+
+void UCombatProxyMovementComponent::MoveKinematic(const FVector& Position, const FVector& InVelocity, const FRotator& Rotation, float DeltaTime)
+{
+	if (!CharacterOwner || !UpdatedComponent)
+	{
+		return;
+	}
+
+	// Dead characters stay where they fell
+	if (MovementMode == MOVE_None)
+	{
+		Velocity = FVector::ZeroVector;
+		Acceleration = FVector::ZeroVector;
+		return;
+	}
+
+	// Play back knockback as a displacement that eases back onto the networked path
+	if (!KnockbackVelocity.IsNearlyZero() || !KnockbackOffset.IsNearlyZero())
+	{
+		KnockbackOffset += KnockbackVelocity * DeltaTime;
+		KnockbackVelocity *= FMath::Exp(-KnockbackBraking * DeltaTime);
+		KnockbackOffset *= FMath::Exp(-KnockbackRecoverySpeed * DeltaTime);
+	}
+
+	FVector NewLocation = Position + KnockbackOffset;
+	const float HalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	// Grounded characters are snapped onto the probed ground; airborne ones follow the networked height
+	float GroundZ = 0.0f;
+	const bool bOnGround = FindGroundHeight(NewLocation, GroundZ)
+		&& Position.Z - HalfHeight - GroundZ <= AirborneHeight
+		&& InVelocity.Z <= UE_KINDA_SMALL_NUMBER;
+
+	if (bOnGround)
+	{
+		NewLocation.Z = GroundZ + HalfHeight;
+	}
+
+	UpdatedComponent->SetWorldLocationAndRotation(NewLocation, Rotation, false, nullptr, ETeleportType::None);
+
+	// What the animation blueprint reads from a simulated character
+	Velocity = bOnGround ? FVector(InVelocity.X, InVelocity.Y, 0.0f) : InVelocity;
+	Acceleration = Velocity.SizeSquared2D() > UE_KINDA_SMALL_NUMBER
+		? Velocity.GetSafeNormal2D() * GetMaxAcceleration()
+		: FVector::ZeroVector;
+
+	const EMovementMode NewMode = bOnGround ? MOVE_Walking : MOVE_Falling;
+	if (MovementMode != NewMode)
+	{
+		const bool bLanded = NewMode == MOVE_Walking;
+		SetMovementMode(NewMode);
+
+		if (bLanded)
+		{
+			CharacterOwner->Landed(GroundHit);
+		}
+	}
+}
+
+bool UCombatProxyMovementComponent::FindGroundHeight(const FVector& Location, float& OutGroundZ)
+{
+	if (!bHasGroundProbe || FVector::DistSquared2D(Location, GroundProbeLocation) > FMath::Square(GroundProbeReuseDistance))
+	{
+		const float HalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		const FVector Start = Location + FVector(0.0f, 0.0f, MaxStepHeight);
+		const FVector End = Location - FVector(0.0f, 0.0f, HalfHeight + GroundProbeDepth);
+
+		// Only level geometry counts as ground, so proxies never stand on each other
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(CombatProxyGroundProbe), false, CharacterOwner);
+		const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+		bGroundFound = GetWorld()->LineTraceSingleByObjectType(GroundHit, Start, End, ObjectParams, Params);
+
+		GroundProbeLocation = Location;
+		bHasGroundProbe = true;
+	}
+
+	OutGroundZ = GroundHit.ImpactPoint.Z;
+	return bGroundFound;
+}
@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatPredictedMovementComponent.h"
+#include "CombatProxyMovementComponent.generated.h"
+
+/**
+ * Kinematic movement for characters whose position comes from the network.
+ *
+ * A remote player's path has already been simulated by its owner, so running the full walking and
+ * falling simulation again only costs sweeps and floor checks to arrive where the interpolation
+ * buffer already says it is. This component never ticks. Its owner hands it the interpolated
+ * position and velocity each frame, and it places the capsule there without sweeping, snapping it
+ * to the ground found by a single cached line trace.
+ *
+ * Velocity, acceleration and the walking/falling movement mode are still kept up to date, so the
+ * animation blueprint reads the same values it would from a simulated character.
+ *
+ * Derives from the predicted component only because ACombatCharacter already replaces the movement
+ * component class, and subclasses may only narrow that replacement. Nothing is ever predicted.
+ */
+UCLASS()
+class UCombatProxyMovementComponent : public UCombatPredictedMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UCombatProxyMovementComponent();
+
+	virtual void BeginPlay() override;
+
+	/** Knockback is played back as an offset from the networked path, which then decays */
+	virtual void AddImpulse(FVector Impulse, bool bVelocityChange = false) override;
+
+	/**
+	 * Places the capsule for this frame.
+	 * @param Position interpolated capsule location
+	 * @param InVelocity interpolated velocity, reported to animation
+	 * @param Rotation facing to apply along with the location
+	 * @param DeltaTime time since the last call, used to play back knockback
+	 */
+	void MoveKinematic(const FVector& Position, const FVector& InVelocity, const FRotator& Rotation, float DeltaTime);
+
+	/** Forces a new ground probe on the next move, e.g. after a teleport */
+	void InvalidateGroundProbe() { bHasGroundProbe = false; }
+
+	/** Forgets knockback, motion and the ground probe, for a pawn reused for another player */
+	void ResetKinematicState();
+
+protected:
+
+	/**
+	 * Finds the ground below Location, reusing the last probe while the character stays near where it was taken.
+	 * @return false if there is no ground within reach
+	 */
+	bool FindGroundHeight(const FVector& Location, float& OutGroundZ);
+
+	/** The ground is probed again once the character has moved this far horizontally from the last probe */
+	UPROPERTY(EditAnywhere, Category="Proxy Movement", meta=(ClampMin=0, Units="cm"))
+	float GroundProbeReuseDistance = 25.0f;
+
+	/** How far below the capsule the ground probe reaches */
+	UPROPERTY(EditAnywhere, Category="Proxy Movement", meta=(ClampMin=0, Units="cm"))
+	float GroundProbeDepth = 500.0f;
+
+	/** The character counts as falling once the networked position is this far above the ground */
+	UPROPERTY(EditAnywhere, Category="Proxy Movement", meta=(ClampMin=0, Units="cm"))
+	float AirborneHeight = 15.0f;
+
+	/** How quickly a knockback's velocity dies off, per second */
+	UPROPERTY(EditAnywhere, Category="Proxy Movement", meta=(ClampMin=0))
+	float KnockbackBraking = 6.0f;
+
+	/** How quickly a knockback's displacement returns to the networked path, per second */
+	UPROPERTY(EditAnywhere, Category="Proxy Movement", meta=(ClampMin=0))
+	float KnockbackRecoverySpeed = 2.0f;
+
+private:
+
+	/** Last ground probe, and where it was taken */
+	FVector GroundProbeLocation = FVector::ZeroVector;
+	FHitResult GroundHit;
+	bool bHasGroundProbe = false;
+	bool bGroundFound = false;
+
+	/** Horizontal knockback being played back on top of the networked path */
+	FVector KnockbackVelocity = FVector::ZeroVector;
+	FVector KnockbackOffset = FVector::ZeroVector;
+};
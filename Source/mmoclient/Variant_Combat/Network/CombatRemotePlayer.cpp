@@ -2,17 +2,22 @@
 
 #include "CombatRemotePlayer.h"
 #include "CombatRemotePlayerController.h"
+#include "CombatProxyMovementComponent.h"
+#include "CombatRemotePlayerManager.h"
+#include "CombatNetworkProtocol.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/WidgetComponent.h"
 #include "CombatLifeBar.h"
 
-ACombatRemotePlayer::ACombatRemotePlayer()
+ACombatRemotePlayer::ACombatRemotePlayer(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCombatProxyMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
-	// Enable ticking for interpolation
-	PrimaryActorTick.bCanEverTick = true;
+	// Moved by UCombatRemotePlayerManager instead of ticking
+	PrimaryActorTick.bCanEverTick = false;
 
 	// Set the AI controller class
 	AIControllerClass = ACombatRemotePlayerController::StaticClass();
@@ -53,21 +58,129 @@ void ACombatRemotePlayer::BeginPlay()
 	}
 
 	// Configure movement component
-	if (UCharacterMovementComponent* MovementComp = GetCharacterMovement())
+	ProxyMovement = Cast<UCombatProxyMovementComponent>(GetCharacterMovement());
+	if (ProxyMovement)
 	{
-		MovementComp->GravityScale = 1.0f;
-		MovementComp->bEnablePhysicsInteraction = false;
+		ProxyMovement->bEnablePhysicsInteraction = false;
 		// Don't orient to movement - rotation comes from network
-		MovementComp->bOrientRotationToMovement = false;
+		ProxyMovement->bOrientRotationToMovement = false;
 	}
 
-	// Keep default pawn collision so attacks can hit remote players
-	// bEnablePhysicsInteraction = false above prevents pushing
+	// Keep default pawn collision so attacks can hit remote players, but don't let another
+	// player's movement trigger local volumes or pay for overlap updates on every placement
+	GetCapsuleComponent()->SetGenerateOverlapEvents(false);
+	GetMesh()->SetGenerateOverlapEvents(false);
 
 	// Initialize states
 	CurrentState.Position = GetActorLocation();
 	CurrentState.Rotation = GetActorRotation();
-	PreviousState = CurrentState;
+
+	RegisterWithManager();
+}
+
+void ACombatRemotePlayer::RegisterWithManager()
+{
+	// The manager owns our interpolation buffer and moves us every frame
+	if (UCombatRemotePlayerManager* Manager = GetWorld()->GetSubsystem<UCombatRemotePlayerManager>())
+	{
+		ProxyManager = Manager;
+		Manager->RegisterProxy(this);
+	}
+
+	if (FCombatInterpolationBuffer* InterpolationBuffer = GetInterpolationBuffer())
+	{
+		InterpolationBuffer->Configure(MaxExtrapolationTime, MaxExtrapolationDistance);
+	}
+}
+
+void ACombatRemotePlayer::ReturnToPool()
+{
+	if (bIsPooled)
+	{
+		return;
+	}
+	bIsPooled = true;
+
+	// Stop being moved, and drop the buffer and history of the player we showed
+	if (UCombatRemotePlayerManager* Manager = ProxyManager.Get())
+	{
+		Manager->UnregisterProxy(this);
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.0f);
+	}
+
+	// Nothing to draw, hit, simulate or animate until the pawn is reused
+	GetMesh()->SetSimulatePhysics(false);
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	GetMesh()->SetComponentTickEnabled(false);
+	if (LifeBar)
+	{
+		LifeBar->SetComponentTickEnabled(false);
+	}
+
+	PlayerId.Empty();
+}
+
+void ACombatRemotePlayer::ActivateFromPool(const FString& InPlayerId, const FVector& Position)
+{
+	if (!bIsPooled)
+	{
+		return;
+	}
+	bIsPooled = false;
+
+	PlayerId = InPlayerId;
+	SetActorLocationAndRotation(Position, FRotator::ZeroRotator, false, nullptr, ETeleportType::ResetPhysics);
+
+	if (ProxyMovement)
+	{
+		ProxyMovement->ResetKinematicState();
+	}
+
+	RegisterWithManager();
+
+	// Forget everything about the player this pawn showed last
+	CurrentState = FCombatNetworkState();
+	CurrentState.Position = Position;
+	LastAnimState = ECombatAnimationState::Idle;
+	LastComboStage = 0;
+	LastCombatEventSequence = INDEX_NONE;
+	bHasCombatEventStream = false;
+	bIsAttacking = false;
+	bHasLoopedChargedAttack = false;
+	ComboCount = 0;
+	CurrentHP = MaxHP;
+
+	// Out of ragdoll, with a fresh buffer, full life bar and no pending events
+	HandleRespawn();
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	GetMesh()->SetComponentTickEnabled(true);
+	if (LifeBar)
+	{
+		LifeBar->SetComponentTickEnabled(true);
+	}
+}
+
+void ACombatRemotePlayer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCombatRemotePlayerManager* Manager = ProxyManager.Get())
+	{
+		Manager->UnregisterProxy(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+FCombatInterpolationBuffer* ACombatRemotePlayer::GetInterpolationBuffer() const
+{
+	UCombatRemotePlayerManager* Manager = ProxyManager.Get();
+	return Manager ? Manager->FindInterpolationBuffer(this) : nullptr;
 }
 
 void ACombatRemotePlayer::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -94,10 +207,8 @@ void ACombatRemotePlayer::ApplyDamage(float Damage, AActor* DamageCauser, const
 {
 	// Apply visual effects without modifying HP (HP comes from network)
 
-	// Pause network position updates during hit reaction
-	HitReactionTimer = 0.5f;
-
-	// Apply knockback via CharacterMovement (same as local player)
+	// Apply knockback via CharacterMovement (same as local player). The proxy mover plays it back
+	// on top of the networked path
 	GetCharacterMovement()->AddImpulse(DamageImpulse, true);
 
 	// Enable physics blend (same as local player) - NOT full simulate physics
@@ -131,62 +242,72 @@ void ACombatRemotePlayer::ApplyDamage(float Damage, AActor* DamageCauser, const
 	ReceivedDamage(Damage, DamageLocation, DamageImpulse.GetSafeNormal());
 }
 
-void ACombatRemotePlayer::Tick(float DeltaTime)
+void ACombatRemotePlayer::ApplyInterpolatedState(const FCombatInterpolatedState& Sample, float DeltaTime)
 {
-	Super::Tick(DeltaTime);
-
-	// Handle hit reaction timer - pause network position updates during hit reaction
-	if (HitReactionTimer > 0.0f)
+	if (!ProxyMovement)
 	{
-		HitReactionTimer -= DeltaTime;
-
-		// Don't chase network position during hit reaction
 		return;
 	}
 
-	FVector CurrentLocation = GetActorLocation();
-	FVector TargetLocation = CurrentState.Position;
-
-	// Horizontal movement with AddMovementInput (drives animation)
-	FVector ToTarget = TargetLocation - CurrentLocation;
-	ToTarget.Z = 0;
-	float Distance = ToTarget.Size();
-
-	if (Distance > 5.0f)
+	// Blend out corrections to the path instead of jumping onto it
+	ConvergenceOffset *= ConvergenceTime > 0.0f ? FMath::Exp(-DeltaTime / ConvergenceTime) : 0.0f;
+	if (ConvergenceOffset.IsNearlyZero(0.1))
 	{
-		FVector Direction = ToTarget.GetSafeNormal();
-		float InputScale = FMath::Clamp(Distance / 100.0f, 0.5f, 1.0f);
-		AddMovementInput(Direction, InputScale);
+		ConvergenceOffset = FVector::ZeroVector;
 	}
+
+	// Place the capsule on the interpolated path; only yaw comes from the network, characters don't pitch or roll
+	ProxyMovement->MoveKinematic(Sample.Position + ConvergenceOffset, Sample.Velocity, FRotator(0.0f, Sample.Yaw, 0.0f), DeltaTime);
+
+	// Actions play when the pawn gets to where they happened
+	PlayDueCombatEvents(Sample.RenderTime);
 }
 
 void ACombatRemotePlayer::ApplyNetworkState(const FCombatNetworkState& NewState)
 {
-	// Store previous state for interpolation reference
-	PreviousState = CurrentState;
+	const FCombatNetworkState PreviousState = CurrentState;
 	CurrentState = NewState;
-	StateReceiveTime = GetWorld()->GetTimeSeconds();
 
-	// If this is a big horizontal position change (like first update or teleport), teleport there
-	FVector CurrentLoc = GetActorLocation();
-	float HorizontalDistSq = FMath::Square(CurrentLoc.X - NewState.Position.X) + FMath::Square(CurrentLoc.Y - NewState.Position.Y);
-	if (HorizontalDistSq > 40000.0f) // More than 200 units away horizontally
+	if (FCombatInterpolationBuffer* InterpolationBuffer = GetInterpolationBuffer())
 	{
-		// Teleport X/Y only, keep current Z so we fall to ground
-		SetActorLocation(FVector(NewState.Position.X, NewState.Position.Y, CurrentLoc.Z));
-	}
+		// The first state, or one far from the previous (a teleport or respawn), is snapped to
+		const bool bTeleport = InterpolationBuffer->IsEmpty()
+			|| FVector::DistSquared2D(NewState.Position, PreviousState.Position) > FMath::Square(TeleportDistance);
+		if (bTeleport)
+		{
+			// Teleport X/Y only, keep current Z until the ground under the new position has been probed
+			SetActorLocation(FVector(NewState.Position.X, NewState.Position.Y, GetActorLocation().Z));
+			if (ProxyMovement)
+			{
+				ProxyMovement->InvalidateGroundProbe();
+			}
+
+			// Don't interpolate across the jump
+			InterpolationBuffer->Reset();
+			ConvergenceOffset = FVector::ZeroVector;
+			InterpolationBuffer->AddState(NewState, FPlatformTime::Seconds());
+		}
+		else
+		{
+			// A state can move the path at the time being drawn, most of all when it ends an extrapolation.
+			// Keep drawing the pawn where it was and let the offset decay, so it converges instead of snapping
+			const double RenderTime = ProxyManager.IsValid() ? ProxyManager->GetRenderTime(this) : 0.0;
+			FCombatInterpolatedState Before;
+			const bool bWasSampled = RenderTime > 0.0 && InterpolationBuffer->Sample(RenderTime, Before);
 
-	// Apply rotation from network (only yaw - characters don't pitch/roll)
-	SetActorRotation(FRotator(0.0f, NewState.Rotation.Yaw, 0.0f));
+			InterpolationBuffer->AddState(NewState, FPlatformTime::Seconds());
 
-	// Check for animation state changes
-	if (NewState.AnimState != LastAnimState || NewState.ComboStage != LastComboStage)
-	{
-		OnAnimationStateChanged(NewState.AnimState, NewState.ComboStage);
-		LastAnimState = NewState.AnimState;
-		LastComboStage = NewState.ComboStage;
+			FCombatInterpolatedState After;
+			if (bWasSampled && InterpolationBuffer->Sample(RenderTime, After))
+			{
+				ConvergenceOffset = (ConvergenceOffset + Before.Position - After.Position).GetClampedToMaxSize(TeleportDistance);
+			}
+		}
 	}
 
+	// Check for animation state changes
+	ApplyAnimationState(NewState.AnimState, NewState.ComboStage);
+
 	// Update life bar if HP changed
 	if (NewState.CurrentHP != PreviousState.CurrentHP || NewState.MaxHP != PreviousState.MaxHP)
 	{
@@ -194,8 +315,24 @@ void ACombatRemotePlayer::ApplyNetworkState(const FCombatNetworkState& NewState)
 	}
 }
 
+void ACombatRemotePlayer::ApplyAnimationState(ECombatAnimationState NewAnimState, int32 NewComboStage)
+{
+	if (NewAnimState != LastAnimState || NewComboStage != LastComboStage)
+	{
+		OnAnimationStateChanged(NewAnimState, NewComboStage);
+		LastAnimState = NewAnimState;
+		LastComboStage = NewComboStage;
+	}
+}
+
 void ACombatRemotePlayer::OnAnimationStateChanged(ECombatAnimationState NewState, int32 NewComboStage)
 {
+	// Montages follow the combat event stream; sampled states would replay them late or cut them short
+	if (bHasCombatEventStream)
+	{
+		return;
+	}
+
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 	if (!AnimInstance)
 	{
@@ -211,63 +348,22 @@ void ACombatRemotePlayer::OnAnimationStateChanged(ECombatAnimationState NewState
 			break;
 
 		case ECombatAnimationState::Jumping:
-			// Trigger jump so the animation blueprint sees IsFalling() = true
-			if (GetCharacterMovement() && !GetCharacterMovement()->IsFalling())
-			{
-				Jump();
-			}
+			// Nothing to trigger: the proxy mover switches to falling as soon as the networked path leaves the ground
 			break;
 
 		case ECombatAnimationState::ComboAttack:
-			// Play combo attack montage
-			if (ComboAttackMontage)
-			{
-				// If already playing, jump to the correct section
-				if (AnimInstance->Montage_IsPlaying(ComboAttackMontage))
-				{
-					if (NewComboStage > 0 && NewComboStage < ComboSectionNames.Num())
-					{
-						AnimInstance->Montage_JumpToSection(ComboSectionNames[NewComboStage], ComboAttackMontage);
-					}
-				}
-				else
-				{
-					// Start playing the montage
-					AnimInstance->Montage_Play(ComboAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
-
-					// Jump to correct section if not first attack
-					if (NewComboStage > 0 && NewComboStage < ComboSectionNames.Num())
-					{
-						AnimInstance->Montage_JumpToSection(ComboSectionNames[NewComboStage], ComboAttackMontage);
-					}
-				}
-			}
+			// Play combo attack montage, at the correct section if not the first attack
+			PlayComboSection(NewComboStage, false);
 			break;
 
 		case ECombatAnimationState::ChargedAttackCharging:
-			// Play charged attack montage (charging phase)
-			if (ChargedAttackMontage)
-			{
-				if (!AnimInstance->Montage_IsPlaying(ChargedAttackMontage))
-				{
-					AnimInstance->Montage_Play(ChargedAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
-				}
-				// Stay in charge loop section
-				AnimInstance->Montage_JumpToSection(ChargeLoopSection, ChargedAttackMontage);
-			}
+			// Stay in charge loop section
+			PlayChargedSection(ChargeLoopSection, false);
 			break;
 
 		case ECombatAnimationState::ChargedAttackRelease:
-			// Play charged attack release
-			if (ChargedAttackMontage)
-			{
-				if (!AnimInstance->Montage_IsPlaying(ChargedAttackMontage))
-				{
-					AnimInstance->Montage_Play(ChargedAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
-				}
-				// Jump to attack section
-				AnimInstance->Montage_JumpToSection(ChargeAttackSection, ChargedAttackMontage);
-			}
+			// Jump to attack section
+			PlayChargedSection(ChargeAttackSection, false);
 			break;
 
 		case ECombatAnimationState::TakingDamage:
@@ -285,6 +381,128 @@ void ACombatRemotePlayer::OnAnimationStateChanged(ECombatAnimationState NewState
 	}
 }
 
+void ACombatRemotePlayer::QueueCombatEvent(const FCombatEvent& Event)
+{
+	// The stream is ordered, so anything not newer than the last event is a duplicate
+	if (LastCombatEventSequence != INDEX_NONE && !CombatNetProtocol::IsSequenceNewer(Event.Sequence, static_cast<uint16>(LastCombatEventSequence)))
+	{
+		return;
+	}
+
+	LastCombatEventSequence = Event.Sequence;
+	bHasCombatEventStream = true;
+	PendingCombatEvents.Add(Event);
+}
+
+void ACombatRemotePlayer::PlayDueCombatEvents(double RenderTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	int32 NumDue = 0;
+	for (const FCombatEvent& Event : PendingCombatEvents)
+	{
+		// Untimed events play on arrival; timed ones when the pawn has reached the moment they happened
+		const bool bDue = Event.Timestamp <= 0.0
+			|| Event.Timestamp <= RenderTime
+			|| Now - Event.ReceiveTime >= MaxCombatEventDelay;
+		if (!bDue)
+		{
+			break;
+		}
+
+		PlayCombatEvent(Event);
+		++NumDue;
+	}
+
+	if (NumDue > 0)
+	{
+		PendingCombatEvents.RemoveAt(0, NumDue, EAllowShrinking::No);
+	}
+}
+
+void ACombatRemotePlayer::PlayCombatEvent(const FCombatEvent& Event)
+{
+	switch (Event.Type)
+	{
+		case ECombatEventType::AttackStart:
+			PlayComboSection(0, true);
+			break;
+
+		case ECombatEventType::ComboAdvance:
+			PlayComboSection(Event.ComboStage, false);
+			break;
+
+		case ECombatEventType::ChargeStart:
+			// The montage's notifies keep looping the charge while the flag is up, as they do for the local player
+			bIsChargingAttack = true;
+			PlayChargedSection(NAME_None, true);
+			break;
+
+		case ECombatEventType::ChargeRelease:
+			bIsChargingAttack = false;
+			PlayChargedSection(ChargeAttackSection, false);
+			break;
+
+		case ECombatEventType::Hit:
+			if (HitReactionMontage)
+			{
+				UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+				if (AnimInstance && !AnimInstance->Montage_IsPlaying(HitReactionMontage))
+				{
+					AnimInstance->Montage_Play(HitReactionMontage, 1.0f);
+				}
+			}
+			break;
+
+		case ECombatEventType::Death:
+			// Same as the Dead state: stop in place rather than ragdoll through the floor
+			if (UCharacterMovementComponent* MovementComp = GetCharacterMovement())
+			{
+				MovementComp->DisableMovement();
+			}
+			break;
+	}
+}
+
+void ACombatRemotePlayer::PlayComboSection(int32 ComboStage, bool bRestart)
+{
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (!AnimInstance || !ComboAttackMontage)
+	{
+		return;
+	}
+
+	if (bRestart || !AnimInstance->Montage_IsPlaying(ComboAttackMontage))
+	{
+		AnimInstance->Montage_Play(ComboAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+	}
+
+	// The first attack is the montage's first section
+	if (ComboStage > 0 && ComboStage < ComboSectionNames.Num())
+	{
+		AnimInstance->Montage_JumpToSection(ComboSectionNames[ComboStage], ComboAttackMontage);
+	}
+}
+
+void ACombatRemotePlayer::PlayChargedSection(FName Section, bool bRestart)
+{
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (!AnimInstance || !ChargedAttackMontage)
+	{
+		return;
+	}
+
+	if (bRestart || !AnimInstance->Montage_IsPlaying(ChargedAttackMontage))
+	{
+		AnimInstance->Montage_Play(ChargedAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+	}
+
+	if (!Section.IsNone())
+	{
+		AnimInstance->Montage_JumpToSection(Section, ChargedAttackMontage);
+	}
+}
+
 void ACombatRemotePlayer::HandleDeath()
 {
 	// Disable movement
@@ -321,6 +539,15 @@ void ACombatRemotePlayer::HandleRespawn()
 		MovementComp->SetMovementMode(MOVE_Walking);
 	}
 
+	// States from before the respawn would pull the pawn back to where it died, and its events would kill it again
+	if (FCombatInterpolationBuffer* InterpolationBuffer = GetInterpolationBuffer())
+	{
+		InterpolationBuffer->Reset();
+	}
+	ConvergenceOffset = FVector::ZeroVector;
+	PendingCombatEvents.Reset();
+	bIsChargingAttack = false;
+
 	// Show the life bar
 	if (LifeBar)
 	{
@@ -5,28 +5,52 @@
 #include "CoreMinimal.h"
 #include "CombatCharacter.h"
 #include "CombatNetworkTypes.h"
+#include "CombatNetworkInterpolation.h"
 #include "CombatRemotePlayer.generated.h"
 
+class UCombatProxyMovementComponent;
+class UCombatRemotePlayerManager;
+
 /**
  * Remote player pawn that displays another player's state received over the network.
  * Inherits from CombatCharacter to reuse visuals, animations, and life bar,
  * but disables input handling since state is driven by network updates.
+ * Movement is kinematic: the capsule is placed on the interpolated path by UCombatProxyMovementComponent.
+ * Remote players don't tick; UCombatRemotePlayerManager samples all of them at once and moves each one.
  */
 UCLASS(Blueprintable)
 class ACombatRemotePlayer : public ACombatCharacter
 {
 	GENERATED_BODY()
 
+	friend class UCombatRemotePlayerManager;
+
 public:
-	ACombatRemotePlayer();
+	ACombatRemotePlayer(const FObjectInitializer& ObjectInitializer);
 
 	/**
 	 * Apply a network state update to this remote player
-	 * Handles interpolation and animation state changes
+	 * Queues the state for interpolation and handles animation state changes
 	 */
 	UFUNCTION(BlueprintCallable, Category="Network")
 	void ApplyNetworkState(const FCombatNetworkState& NewState);
 
+	/**
+	 * Apply only the animation part of a network state, e.g. for a state superseded before it was applied.
+	 * Plays the transition if it differs from the last one processed
+	 */
+	void ApplyAnimationState(ECombatAnimationState NewAnimState, int32 NewComboStage);
+
+	/** Places the pawn where its interpolation buffer was sampled this frame. Called by the remote player manager */
+	void ApplyInterpolatedState(const FCombatInterpolatedState& Sample, float DeltaTime);
+
+	/**
+	 * Queue a combat event to play once the interpolation timeline reaches it.
+	 * Events already queued or played are ignored. Once a player sends events, they drive its attack
+	 * montages instead of the sampled animation state
+	 */
+	void QueueCombatEvent(const FCombatEvent& Event);
+
 	/**
 	 * Set the player ID for this remote player
 	 */
@@ -39,6 +63,21 @@ public:
 	UFUNCTION(BlueprintPure, Category="Network")
 	FString GetPlayerId() const { return PlayerId; }
 
+	/**
+	 * Hide this pawn and stop everything it does per frame, so it can wait in UCombatRemotePlayerPool.
+	 * It keeps its components and controller
+	 */
+	void ReturnToPool();
+
+	/** Reset this pooled pawn for PlayerId, place it at Position and show it again */
+	void ActivateFromPool(const FString& InPlayerId, const FVector& Position);
+
+	/** Whether this pawn is waiting in the pool */
+	bool IsPooled() const { return bIsPooled; }
+
+	/** Newest network state received */
+	const FCombatNetworkState& GetLastNetworkState() const { return CurrentState; }
+
 	/** Override to prevent ragdoll physics (causes floor clipping) */
 	virtual void HandleDeath() override;
 
@@ -50,12 +89,12 @@ public:
 
 protected:
 
-	/** Called every frame */
-	virtual void Tick(float DeltaTime) override;
-
 	/** Called when play begins */
 	virtual void BeginPlay() override;
 
+	/** Called when play ends */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Override to prevent input binding */
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
@@ -69,6 +108,18 @@ protected:
 	/** Handle animation state changes from network */
 	void OnAnimationStateChanged(ECombatAnimationState NewState, int32 NewComboStage);
 
+	/** Play the queued combat events that happened at or before RenderTime on the server timeline */
+	void PlayDueCombatEvents(double RenderTime);
+
+	/** Play one combat event's animation */
+	void PlayCombatEvent(const FCombatEvent& Event);
+
+	/** Play the combo montage at a section, starting it if needed, or restarting it if bRestart */
+	void PlayComboSection(int32 ComboStage, bool bRestart);
+
+	/** Play the charged attack montage at a section, or from its start if Section is none. Starts it if needed, or restarts it if bRestart */
+	void PlayChargedSection(FName Section, bool bRestart);
+
 	/** Update life bar from network state */
 	void UpdateLifeBarFromNetwork(float HP, float MaxHPValue);
 
@@ -78,14 +129,23 @@ private:
 	UPROPERTY()
 	FString PlayerId;
 
-	/** Previous network state for interpolation */
-	FCombatNetworkState PreviousState;
-
-	/** Current target network state */
+	/** Newest network state received */
 	FCombatNetworkState CurrentState;
 
-	/** Time when we received the current state */
-	float StateReceiveTime = 0.0f;
+	/** Returns the received states, sampled each tick a little in the past. Owned by the manager; null while unregistered */
+	FCombatInterpolationBuffer* GetInterpolationBuffer() const;
+
+	/** Have the manager move this pawn, with a new, empty interpolation buffer */
+	void RegisterWithManager();
+
+	/** Whether this pawn is waiting in the pool */
+	bool bIsPooled = false;
+
+	/** Moves this pawn along with every other remote player */
+	TWeakObjectPtr<UCombatRemotePlayerManager> ProxyManager;
+
+	/** Index of this pawn's data in the manager, or INDEX_NONE */
+	int32 ProxySlot = INDEX_NONE;
 
 	/** Last animation state we processed */
 	ECombatAnimationState LastAnimState = ECombatAnimationState::Idle;
@@ -93,12 +153,44 @@ private:
 	/** Last combo stage we processed */
 	int32 LastComboStage = 0;
 
-	/** Timer for hit reaction - pause network position updates during hit */
-	float HitReactionTimer = 0.0f;
+	/** Combat events received but not yet reached by the interpolation timeline, in sequence order */
+	TArray<FCombatEvent> PendingCombatEvents;
 
-	/** Position interpolation speed */
-	UPROPERTY(EditDefaultsOnly, Category="Network")
-	float PositionInterpSpeed = 10.0f;
+	/** Sequence of the newest combat event queued, or INDEX_NONE */
+	int32 LastCombatEventSequence = INDEX_NONE;
+
+	/** Whether this player sends combat events, so its sampled animation state no longer drives montages */
+	bool bHasCombatEventStream = false;
+
+	/** Longest a combat event waits for the timeline, in seconds, in case its timestamp can't be matched to ours */
+	UPROPERTY(EditDefaultsOnly, Category="Network", meta=(ClampMin="0.0", Units="s"))
+	float MaxCombatEventDelay = 0.5f;
+
+	/** Places the capsule along the interpolated path without simulating movement */
+	UPROPERTY()
+	TObjectPtr<UCombatProxyMovementComponent> ProxyMovement;
+
+	/**
+	 * How long the pawn keeps moving along its last velocity once it runs out of states, in seconds.
+	 * Senders with an adaptive send rate only send a steadily moving player every heartbeat, so this should cover the heartbeat interval
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Network", meta=(ClampMin="0.0", Units="s"))
+	float MaxExtrapolationTime = 1.25f;
+
+	/** Furthest the pawn moves along its last velocity once it runs out of states. 0 for no limit besides the time */
+	UPROPERTY(EditDefaultsOnly, Category="Network", meta=(ClampMin="0.0", Units="cm"))
+	float MaxExtrapolationDistance = 500.0f;
+
+	/** Time constant the pawn converges onto a corrected path with, after a new state moved it, in seconds */
+	UPROPERTY(EditDefaultsOnly, Category="Network", meta=(ClampMin="0.0", Units="s"))
+	float ConvergenceTime = 0.15f;
+
+	/** A new state further than this from the previous one, horizontally, is a teleport: the pawn snaps to it instead of converging */
+	UPROPERTY(EditDefaultsOnly, Category="Network", meta=(ClampMin="0.0", Units="cm"))
+	float TeleportDistance = 1000.0f;
+
+	/** Where the pawn is drawn relative to its sampled path. Absorbs corrections to the path and decays over ConvergenceTime */
+	FVector ConvergenceOffset = FVector::ZeroVector;
 
 	/** Rotation interpolation speed */
 	UPROPERTY(EditDefaultsOnly, Category="Network")
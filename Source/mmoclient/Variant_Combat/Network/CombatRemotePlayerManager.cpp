@@ -0,0 +1,224 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatRemotePlayerManager.h"
+#include "CombatRemotePlayer.h"
+#include "CombatNetworkSubsystem.h"
+#include "CombatNetworkSettings.h"
+#include "Async/ParallelFor.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+namespace
+{
+	/** Proxies sampled per worker task. Sampling one is cheap, so small batches would cost more to schedule than to run */
+	constexpr int32 SampleBatchSize = 32;
+}
+
+void FCombatRemotePlayerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Manager)
+	{
+		Manager->TickProxies(DeltaTime);
+	}
+}
+
+FString FCombatRemotePlayerTickFunction::DiagnosticMessage()
+{
+	return TEXT("FCombatRemotePlayerTickFunction");
+}
+
+FName FCombatRemotePlayerTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("CombatRemotePlayerManager"));
+}
+
+bool UCombatRemotePlayerManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatRemotePlayerManager::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (UGameInstance* GameInstance = InWorld.GetGameInstance())
+	{
+		NetworkSubsystem = GameInstance->GetSubsystem<UCombatNetworkSubsystem>();
+	}
+
+	// Before physics, like the character movement it replaces, so animation sees this frame's velocity
+	TickFunction.Manager = this;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PrePhysics;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UCombatRemotePlayerManager::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Manager = nullptr;
+
+	Proxies.Empty();
+	Buffers.Empty();
+	Samples.Empty();
+	SampleValid.Empty();
+	WasExtrapolating.Empty();
+	Histories.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCombatRemotePlayerManager::RegisterProxy(ACombatRemotePlayer* Proxy)
+{
+	if (!Proxy || Proxy->ProxySlot != INDEX_NONE)
+	{
+		return;
+	}
+
+	Proxy->ProxySlot = Proxies.Add(Proxy);
+	Buffers.AddDefaulted();
+	Samples.AddDefaulted();
+	SampleValid.Add(false);
+	WasExtrapolating.Add(false);
+	Histories.AddDefaulted_GetRef().SetWindow(GetDefault<UCombatNetworkSettings>()->LagCompensationWindow);
+
+	// Animate from the pose this frame's placement produced
+	if (USkeletalMeshComponent* Mesh = Proxy->GetMesh())
+	{
+		Mesh->PrimaryComponentTick.AddPrerequisite(this, TickFunction);
+	}
+}
+
+void UCombatRemotePlayerManager::UnregisterProxy(ACombatRemotePlayer* Proxy)
+{
+	if (!Proxy || !Proxies.IsValidIndex(Proxy->ProxySlot) || Proxies[Proxy->ProxySlot] != Proxy)
+	{
+		return;
+	}
+
+	if (USkeletalMeshComponent* Mesh = Proxy->GetMesh())
+	{
+		Mesh->PrimaryComponentTick.RemovePrerequisite(this, TickFunction);
+	}
+
+	const int32 Slot = Proxy->ProxySlot;
+	Proxy->ProxySlot = INDEX_NONE;
+
+	// Keep the arrays dense by moving the last proxy into the freed slot
+	Proxies.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Buffers.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Samples.RemoveAtSwap(Slot, EAllowShrinking::No);
+	SampleValid.RemoveAtSwap(Slot, EAllowShrinking::No);
+	WasExtrapolating.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Histories.RemoveAtSwap(Slot, EAllowShrinking::No);
+
+	if (Proxies.IsValidIndex(Slot) && Proxies[Slot])
+	{
+		Proxies[Slot]->ProxySlot = Slot;
+	}
+}
+
+FCombatInterpolationBuffer* UCombatRemotePlayerManager::FindInterpolationBuffer(const ACombatRemotePlayer* Proxy)
+{
+	if (!Proxy || !Proxies.IsValidIndex(Proxy->ProxySlot) || Proxies[Proxy->ProxySlot] != Proxy)
+	{
+		return nullptr;
+	}
+
+	return &Buffers[Proxy->ProxySlot];
+}
+
+double UCombatRemotePlayerManager::GetRenderTime(const ACombatRemotePlayer* Proxy) const
+{
+	if (!Proxy || !Proxies.IsValidIndex(Proxy->ProxySlot) || Proxies[Proxy->ProxySlot] != Proxy || !SampleValid[Proxy->ProxySlot])
+	{
+		return 0.0;
+	}
+
+	return Samples[Proxy->ProxySlot].RenderTime;
+}
+
+bool UCombatRemotePlayerManager::RewindProxy(const ACombatRemotePlayer* Proxy, double ServerTime, FVector& OutLocation) const
+{
+	if (!Proxy || !Proxies.IsValidIndex(Proxy->ProxySlot) || Proxies[Proxy->ProxySlot] != Proxy)
+	{
+		return false;
+	}
+
+	return Histories[Proxy->ProxySlot].Sample(ServerTime, OutLocation);
+}
+
+bool UCombatRemotePlayerManager::ValidateMeleeHit(const ACombatRemotePlayer* Proxy, double ServerTime, const FVector& TraceStart, const FVector& TraceEnd,
+	float TraceRadius, FVector& OutHitLocation) const
+{
+	FVector RewoundLocation;
+	if (!Proxy || !RewindProxy(Proxy, ServerTime, RewoundLocation))
+	{
+		// Nothing to rewind to; leave the decision to the server
+		return true;
+	}
+
+	const UCapsuleComponent* Capsule = Proxy->GetCapsuleComponent();
+	return CombatLagCompensation::SweepHitsCapsule(TraceStart, TraceEnd, TraceRadius,
+		RewoundLocation, Capsule->GetScaledCapsuleHalfHeight(), Capsule->GetScaledCapsuleRadius(),
+		GetDefault<UCombatNetworkSettings>()->MeleeHitTolerance, OutHitLocation);
+}
+
+void UCombatRemotePlayerManager::TickProxies(float DeltaTime)
+{
+	const int32 NumProxies = Proxies.Num();
+	if (NumProxies == 0)
+	{
+		return;
+	}
+
+	// Render on the synchronized server timeline, or on one inferred from arrivals until it is available,
+	// as far in the past as the connection's jitter requires
+	UCombatNetworkSubsystem* Subsystem = NetworkSubsystem.Get();
+	const bool bClockSynchronized = Subsystem && Subsystem->IsClockSynchronized();
+	const double ServerTime = bClockSynchronized ? Subsystem->GetServerTime() : 0.0;
+	const double LocalTime = FPlatformTime::Seconds();
+	const double Delay = Subsystem ? Subsystem->GetInterpolationDelay() : GetDefault<UCombatNetworkSettings>()->MinInterpolationDelay;
+
+	// Sampling only reads each buffer and writes its own sample, so slots are independent
+	ParallelFor(TEXT("CombatRemotePlayerSample"), NumProxies, SampleBatchSize, [this, bClockSynchronized, ServerTime, LocalTime, Delay](int32 Slot)
+	{
+		const FCombatInterpolationBuffer& Buffer = Buffers[Slot];
+		const double SampleTime = bClockSynchronized ? ServerTime : Buffer.EstimateServerTime(LocalTime);
+		SampleValid[Slot] = Buffer.Sample(SampleTime - Delay, Samples[Slot]);
+	});
+
+	int32 Underruns = 0;
+	double ExtrapolationTime = 0.0;
+
+	// Actors and components are game thread only
+	for (int32 Slot = 0; Slot < NumProxies; ++Slot)
+	{
+		const bool bExtrapolating = SampleValid[Slot] && Samples[Slot].bExtrapolated;
+		if (bExtrapolating)
+		{
+			Underruns += WasExtrapolating[Slot] ? 0 : 1;
+			ExtrapolationTime += DeltaTime;
+		}
+		WasExtrapolating[Slot] = bExtrapolating;
+
+		if (SampleValid[Slot] && Proxies[Slot])
+		{
+			Proxies[Slot]->ApplyInterpolatedState(Samples[Slot], DeltaTime);
+
+			// The networked path, not the drawn capsule: that is what the server can rewind to as well
+			Histories[Slot].Record(Samples[Slot].RenderTime, Samples[Slot].Position);
+		}
+	}
+
+	if (Subsystem)
+	{
+		Subsystem->RecordInterpolationStats(Underruns, ExtrapolationTime);
+	}
+}
@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatNetworkInterpolation.h"
+#include "CombatNetworkLagCompensation.h"
+#include "CombatRemotePlayerManager.generated.h"
+
+class ACombatRemotePlayer;
+class UCombatNetworkSubsystem;
+class UCombatRemotePlayerManager;
+
+/**
+ * The one tick function that moves every remote player in a world
+ */
+USTRUCT()
+struct FCombatRemotePlayerTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** Manager to tick */
+	UCombatRemotePlayerManager* Manager = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatRemotePlayerTickFunction> : public TStructOpsTypeTraitsBase2<FCombatRemotePlayerTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Moves all remote players of a world from a single tick.
+ *
+ * Remote players don't tick themselves. Their interpolation buffers live here in one contiguous
+ * array, indexed by the proxy's slot. Each frame every buffer is sampled in parallel, which only
+ * reads the buffers and writes to a matching array of samples. A second, serial pass then places
+ * each proxy from its sample, which is the only part that touches actors and components.
+ *
+ * The networked position each proxy was drawn at is also recorded against the server time it was
+ * drawn for, so melee hits can be checked against where the target was when the attacker saw it.
+ *
+ * Proxies register in BeginPlay and unregister in EndPlay. Unregistering moves the last proxy into
+ * the freed slot, so the arrays stay dense.
+ */
+UCLASS()
+class UCombatRemotePlayerManager : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Gives Proxy a slot and an empty interpolation buffer */
+	void RegisterProxy(ACombatRemotePlayer* Proxy);
+
+	/** Frees Proxy's slot */
+	void UnregisterProxy(ACombatRemotePlayer* Proxy);
+
+	/** Interpolation buffer of a registered proxy, or null */
+	FCombatInterpolationBuffer* FindInterpolationBuffer(const ACombatRemotePlayer* Proxy);
+
+	/** Samples every buffer in parallel, then moves every proxy */
+	void TickProxies(float DeltaTime);
+
+	/** Server time Proxy was last drawn at, or 0 if it hasn't been drawn yet */
+	double GetRenderTime(const ACombatRemotePlayer* Proxy) const;
+
+	/**
+	 * Where Proxy's networked path had it at ServerTime.
+	 * @return false if ServerTime is outside the lag compensation window
+	 */
+	bool RewindProxy(const ACombatRemotePlayer* Proxy, double ServerTime, FVector& OutLocation) const;
+
+	/**
+	 * Re-runs a melee sphere sweep against Proxy's capsule rewound to ServerTime, the check the server makes.
+	 * @param OutHitLocation where the sweep meets the rewound capsule
+	 * @return true if the sweep hits the rewound capsule, or if ServerTime can't be rewound to and the hit can't be second guessed
+	 */
+	bool ValidateMeleeHit(const ACombatRemotePlayer* Proxy, double ServerTime, const FVector& TraceStart, const FVector& TraceEnd,
+		float TraceRadius, FVector& OutHitLocation) const;
+
+	int32 GetNumProxies() const { return Proxies.Num(); }
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** Registered proxies, indexed by slot */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ACombatRemotePlayer>> Proxies;
+
+	/** Per slot: received states, what they were sampled to this frame, and where they were drawn recently */
+	TArray<FCombatInterpolationBuffer> Buffers;
+	TArray<FCombatInterpolatedState> Samples;
+	TArray<bool> SampleValid;
+	TArray<bool> WasExtrapolating;
+	TArray<FCombatTransformHistory> Histories;
+
+	/** Provides the server timeline states are rendered on */
+	TWeakObjectPtr<UCombatNetworkSubsystem> NetworkSubsystem;
+
+	FCombatRemotePlayerTickFunction TickFunction;
+};
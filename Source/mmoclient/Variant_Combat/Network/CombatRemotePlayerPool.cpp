@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatRemotePlayerPool.h"
+#include "CombatRemotePlayer.h"
+#include "CombatNetworkSettings.h"
+#include "CombatNetworkSubsystem.h"
+#include "Engine/World.h"
+
+bool UCombatRemotePlayerPool::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatRemotePlayerPool::Deinitialize()
+{
+	// The world destroys its actors itself
+	Pooled.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCombatRemotePlayerPool::Prewarm(TSubclassOf<ACombatRemotePlayer> ProxyClass, int32 Count)
+{
+	if (!ProxyClass)
+	{
+		return;
+	}
+
+	while (Pooled.Num() < Count)
+	{
+		ACombatRemotePlayer* Proxy = SpawnProxy(ProxyClass, FVector::ZeroVector);
+		if (!Proxy)
+		{
+			UE_LOG(LogCombatNetwork, Warning, TEXT("Couldn't prewarm remote player pool past %d pawns"), Pooled.Num());
+			return;
+		}
+
+		Proxy->ReturnToPool();
+		Pooled.Add(Proxy);
+	}
+}
+
+ACombatRemotePlayer* UCombatRemotePlayerPool::Acquire(TSubclassOf<ACombatRemotePlayer> ProxyClass, const FString& PlayerId, const FVector& Position, bool& bOutFromPool)
+{
+	bOutFromPool = false;
+	if (!ProxyClass)
+	{
+		return nullptr;
+	}
+
+	// Most recently released first; its memory is the most likely to still be warm
+	for (int32 Index = Pooled.Num() - 1; Index >= 0; --Index)
+	{
+		ACombatRemotePlayer* Proxy = Pooled[Index];
+		if (!IsValid(Proxy))
+		{
+			Pooled.RemoveAtSwap(Index, EAllowShrinking::No);
+			continue;
+		}
+
+		if (Proxy->GetClass() == ProxyClass.Get())
+		{
+			Pooled.RemoveAtSwap(Index, EAllowShrinking::No);
+			Proxy->ActivateFromPool(PlayerId, Position);
+			bOutFromPool = true;
+			return Proxy;
+		}
+	}
+
+	ACombatRemotePlayer* Proxy = SpawnProxy(ProxyClass, Position);
+	if (Proxy)
+	{
+		Proxy->SetPlayerId(PlayerId);
+	}
+	return Proxy;
+}
+
+void UCombatRemotePlayerPool::Release(ACombatRemotePlayer* Proxy)
+{
+	if (!IsValid(Proxy) || Proxy->IsPooled())
+	{
+		return;
+	}
+
+	if (Pooled.Num() >= GetDefault<UCombatNetworkSettings>()->MaxPooledRemotePlayers)
+	{
+		Proxy->Destroy();
+		return;
+	}
+
+	Proxy->ReturnToPool();
+	Pooled.Add(Proxy);
+}
+
+void UCombatRemotePlayerPool::Empty()
+{
+	for (ACombatRemotePlayer* Proxy : Pooled)
+	{
+		if (IsValid(Proxy))
+		{
+			Proxy->Destroy();
+		}
+	}
+	Pooled.Empty();
+}
+
+ACombatRemotePlayer* UCombatRemotePlayerPool::SpawnProxy(TSubclassOf<ACombatRemotePlayer> ProxyClass, const FVector& Position) const
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	return World->SpawnActor<ACombatRemotePlayer>(ProxyClass, Position, FRotator::ZeroRotator, SpawnParams);
+}
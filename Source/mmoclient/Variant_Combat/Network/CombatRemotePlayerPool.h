@@ -0,0 +1,60 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatRemotePlayerPool.generated.h"
+
+class ACombatRemotePlayer;
+
+/**
+ * Keeps spawned remote player pawns around between uses.
+ *
+ * A remote player is a full character with a skeletal mesh, widgets and an AI controller, too much
+ * to construct for every join and garbage collect after every leave. The pool spawns a number of
+ * them up front, hidden and dormant, hands them out on join and takes them back on leave. A pawn
+ * in the pool is hidden, has no collision, isn't animated and isn't moved by the remote player
+ * manager. Joins beyond what the pool holds still spawn, and those pawns join the pool when they
+ * leave, up to its maximum size.
+ */
+UCLASS()
+class UCombatRemotePlayerPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	/** Spawns dormant pawns of ProxyClass until the pool holds Count of them */
+	void Prewarm(TSubclassOf<ACombatRemotePlayer> ProxyClass, int32 Count);
+
+	/**
+	 * Takes a pawn of ProxyClass from the pool, or spawns one if the pool has none, and activates it at Position.
+	 * @param bOutFromPool whether the pawn came from the pool
+	 */
+	ACombatRemotePlayer* Acquire(TSubclassOf<ACombatRemotePlayer> ProxyClass, const FString& PlayerId, const FVector& Position, bool& bOutFromPool);
+
+	/** Deactivates Proxy and keeps it for a later Acquire, or destroys it if the pool is full */
+	void Release(ACombatRemotePlayer* Proxy);
+
+	/** Destroys every pooled pawn */
+	void Empty();
+
+	/** Pawns waiting in the pool */
+	int32 GetNumPooled() const { return Pooled.Num(); }
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** Spawns a pawn of ProxyClass at Position */
+	ACombatRemotePlayer* SpawnProxy(TSubclassOf<ACombatRemotePlayer> ProxyClass, const FVector& Position) const;
+
+	/** Dormant pawns, most recently released last */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ACombatRemotePlayer>> Pooled;
+};
@@ -21,7 +21,8 @@ public class mmoclient : ModuleRules
 			"Slate",
 			"WebSockets",
 			"Json",
-			"JsonUtilities"
+			"JsonUtilities",
+			"DeveloperSettings"
 		});
 
 		PrivateDependencyModuleNames.AddRange(new string[] { });